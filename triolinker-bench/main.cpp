@@ -0,0 +1,306 @@
+/**
+ * triolinker-vjoy
+ * Report-to-output mapping benchmark.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DecodePlan.hpp"
+#include "Feeder.hpp"
+#include "OutputSink.hpp"
+#include "ReplaySource.hpp"
+#include "ReportSource.hpp"
+#include "VJoyOutput.hpp"
+#include "vGenMock.hpp"
+
+static std::atomic<uint64_t> allocations { 0 };
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* result = std::malloc(size ? size : 1))
+	{
+		return result;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+/**
+ * Cycles through a fixed set of pre-generated reports.
+ */
+class SyntheticSource : public ReportSource
+{
+public:
+	SyntheticSource(size_t reportLength, size_t count, uint32_t seed)
+		: m_reportLength(reportLength),
+		  m_count(count),
+		  m_reports(reportLength * REPORT_SET)
+	{
+		std::mt19937 random(seed);
+
+		// Like a real controller, each report changes a single input byte of the previous one.
+		// Byte 0 is the report ID and stays 0.
+		for (size_t i = 1; i < REPORT_SET; i++)
+		{
+			uint8_t* report = &m_reports[i * reportLength];
+			std::copy(report - reportLength, report, report);
+
+			report[1 + random() % (reportLength - 1)] = static_cast<uint8_t>(random());
+		}
+	}
+
+	size_t reportLength() const override
+	{
+		return m_reportLength;
+	}
+
+	bool read(uint8_t* report) override
+	{
+		if (m_next >= m_count)
+		{
+			return false;
+		}
+
+		const uint8_t* source = &m_reports[(m_next++ % REPORT_SET) * m_reportLength];
+		std::copy(source, source + m_reportLength, report);
+		return true;
+	}
+
+	void rewind()
+	{
+		m_next = 0;
+	}
+
+protected:
+	static constexpr size_t REPORT_SET = 4096;
+
+	size_t               m_reportLength;
+	size_t               m_count;
+	size_t               m_next = 0;
+	std::vector<uint8_t> m_reports;
+};
+
+/**
+ * Discards every state, keeping just enough of it that the work isn't optimized out.
+ */
+class NullOutput : public OutputSink
+{
+public:
+	void commit(const JoyState& state) override
+	{
+		m_checksum += static_cast<uint32_t>(state.axes[0]) ^ state.buttons ^ static_cast<uint32_t>(state.pov);
+		++m_commits;
+	}
+
+	uint64_t m_checksum = 0;
+	uint64_t m_commits  = 0;
+};
+
+struct Scenario
+{
+	const char*   name;
+	MappingConfig mapping;
+	size_t        reportLength;
+};
+
+static std::vector<Scenario> scenarios()
+{
+	std::vector<Scenario> result;
+
+	// Trio Linker with a Dreamcast controller: the defaults.
+	result.push_back({ "trio-dreamcast", MappingConfig {}, 8 });
+
+	// Trio Linker with a GameCube controller: both sticks.
+	MappingConfig gamecube;
+	gamecube.buffer_rx = 5;
+	gamecube.buffer_ry = 6;
+	result.push_back({ "trio-gamecube", gamecube, 8 });
+
+	// Dance mat: twelve buttons, arrows reported as buttons, no POV.
+	MappingConfig danceMat;
+	danceMat.dPadAsButtons = true;
+	danceMat.unlinkDpad    = false;
+	result.push_back({ "dance-mat", danceMat, 8 });
+
+	return result;
+}
+
+/**
+ * Run one source through the feeder and print a result line.
+ * @param name Scenario name.
+ * @param plan Decode plan.
+ * @param source Report source, positioned at its first report.
+ * @param options Feeder options.
+ * @param reports Number of reports the source will return.
+ * @param vgen Output mode to drive the vGen mock with, or none to discard states.
+ */
+static void run(const std::string& name, const DecodePlan& plan, ReportSource& source, const FeederOptions& options, uint64_t reports,
+                const std::optional<OutputMode>& vgen)
+{
+	NullOutput                  discard;
+	std::unique_ptr<VJoyOutput> vjoy;
+	OutputSink*                 output = &discard;
+	HDEVICE                     hDev   = INVALID_DEV;
+
+	if (vgen)
+	{
+		AcquireDev(1, DevType::vJoy, &hDev);
+		vjoy   = std::make_unique<VJoyOutput>(hDev, *vgen);
+		output = vjoy.get();
+	}
+
+	Feeder feeder(plan, source, *output, options);
+
+	const uint64_t allocationsBefore = allocations.load();
+	const uint64_t callsBefore       = mockCallCount();
+	const auto     start             = std::chrono::steady_clock::now();
+
+	feeder.run();
+
+	const auto     end        = std::chrono::steady_clock::now();
+	const uint64_t calls      = mockCallCount() - callsBefore;
+	const uint64_t allocated  = allocations.load() - allocationsBefore;
+	const double   seconds    = std::chrono::duration<double>(end - start).count();
+	const double   nsPerReport = seconds * 1e9 / static_cast<double>(reports);
+
+	std::cout << std::left << std::setw(20) << name << std::right
+	          << std::setw(12) << reports
+	          << std::setw(12) << std::fixed << std::setprecision(2) << nsPerReport
+	          << std::setw(16) << std::setprecision(0) << static_cast<double>(reports) / seconds
+	          << std::setw(16) << std::setprecision(6) << static_cast<double>(allocated) / static_cast<double>(reports);
+
+	if (vgen)
+	{
+		std::cout << "  (" << std::setprecision(2) << static_cast<double>(calls) / static_cast<double>(reports) << " vGen calls/report)" << std::endl;
+	}
+	else
+	{
+		std::cout << "  (checksum " << std::hex << discard.m_checksum << std::dec << ")" << std::endl;
+	}
+
+	if (options.latency)
+	{
+		feeder.latency().print(std::cout);
+	}
+
+	if (hDev != INVALID_DEV)
+	{
+		RelinquishDev(hDev);
+	}
+}
+
+/**
+ * Usage: triolinker-bench [--reports N] [--replay capture] [--coalesce] [--threaded] [--latency]
+ *                         [--vgen Delta|Frame] [--vgen-latency ns]
+ */
+int main(int argc, char** argv)
+{
+	uint64_t                  reports = 10'000'000;
+	std::string               replay;
+	FeederOptions             options;
+	std::optional<OutputMode> vgen;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg(argv[i]);
+
+		if (arg == "--reports" && i + 1 < argc)
+		{
+			reports = std::stoull(argv[++i]);
+		}
+		else if (arg == "--replay" && i + 1 < argc)
+		{
+			replay = argv[++i];
+		}
+		else if (arg == "--coalesce")
+		{
+			options.coalesce = true;
+		}
+		else if (arg == "--threaded")
+		{
+			options.threaded = true;
+		}
+		else if (arg == "--latency")
+		{
+			options.latency = true;
+		}
+		else if (arg == "--vgen" && i + 1 < argc)
+		{
+			vgen = std::string(argv[++i]) == "Frame" ? OutputMode::Frame : OutputMode::Delta;
+		}
+		else if (arg == "--vgen-latency" && i + 1 < argc)
+		{
+			mockSetLatency(std::stoull(argv[++i]));
+		}
+	}
+
+	// Nothing reads the trace; recording it would only measure the mock.
+	mockSetTraceSize(0);
+
+	if (reports == 0)
+	{
+		reports = 1;
+	}
+
+	std::cout << std::left << std::setw(20) << "config" << std::right
+	          << std::setw(12) << "reports"
+	          << std::setw(12) << "ns/report"
+	          << std::setw(16) << "reports/sec"
+	          << std::setw(16) << "allocs/report" << std::endl;
+
+	for (const auto& scenario : scenarios())
+	{
+		const DecodePlan plan(scenario.mapping);
+		SyntheticSource  source(scenario.reportLength, reports, 1);
+
+		run(scenario.name, plan, source, options, reports, vgen);
+	}
+
+	if (!replay.empty())
+	{
+		ReplaySource source(replay, false);
+
+		if (!source.valid() || source.count() == 0)
+		{
+			std::cout << "Unable to read capture file " << replay << "." << std::endl;
+			return -1;
+		}
+
+		const MappingConfig mapping;
+		const DecodePlan    buffers(mapping);
+
+		run("replay-buffers", buffers, source, options, source.count(), vgen);
+
+		if (!source.fields().empty())
+		{
+			const DecodePlan descriptor(mapping, source.fields());
+
+			source.rewind();
+			run("replay-descriptor", descriptor, source, options, source.count(), vgen);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * triolinker-vjoy
+ * Capture and replay tests.
+ */
+
+#include <cstring>
+#include <filesystem>
+
+#include "Capture.hpp"
+#include "DecodePlan.hpp"
+#include "ReplaySource.hpp"
+#include "Test.hpp"
+
+/**
+ * Hands out a fixed list of reports.
+ */
+class ListSource : public ReportSource
+{
+public:
+	explicit ListSource(const std::vector<std::vector<uint8_t>>& reports)
+		: m_reports(reports)
+	{
+	}
+
+	size_t reportLength() const override
+	{
+		return m_reports.front().size();
+	}
+
+	bool read(uint8_t* report) override
+	{
+		if (m_next == m_reports.size())
+		{
+			return false;
+		}
+
+		std::memcpy(report, m_reports[m_next++].data(), reportLength());
+		return true;
+	}
+
+protected:
+	const std::vector<std::vector<uint8_t>>& m_reports;
+	size_t                                   m_next = 0;
+};
+
+TEST(CaptureRoundTrip)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "triolinker-capture-test.bin").string();
+
+	const std::vector<std::vector<uint8_t>> reports = {
+		{ 0x01, 0x00, 0x80, 0x80, 0x00 },
+		{ 0x01, 0x10, 0x7F, 0x81, 0xFF },
+		{ 0x01, 0x00, 0x00, 0xFF, 0x42 },
+	};
+
+	const std::vector<HidField> fields = {
+		{ 0x01, 0x30, 1, 16, 8, 0, 255 },
+		{ 0x09, 0x01, 1, 8, 1, 0, 1 },
+	};
+
+	{
+		ListSource      list(reports);
+		CaptureWriter   writer(path, list.reportLength(), fields);
+		RecordingSource recorder(list, writer);
+
+		CHECK(writer.good());
+
+		// Reports pass through the recorder unchanged.
+		uint8_t report[5];
+		size_t  count = 0;
+
+		while (recorder.read(report))
+		{
+			CHECK(std::memcmp(report, reports[count].data(), sizeof(report)) == 0);
+			++count;
+		}
+
+		CHECK_EQUAL(count, reports.size());
+		CHECK(writer.good());
+	}
+
+	{
+		ReplaySource replay(path, false);
+
+		CHECK(replay.valid());
+		CHECK_EQUAL(replay.reportLength(), 5u);
+		CHECK_EQUAL(replay.count(), reports.size());
+		CHECK_EQUAL(replay.fields().size(), fields.size());
+
+		for (size_t i = 0; i < replay.fields().size() && i < fields.size(); i++)
+		{
+			CHECK_EQUAL(replay.fields()[i].usage, fields[i].usage);
+			CHECK_EQUAL(replay.fields()[i].bitOffset, fields[i].bitOffset);
+			CHECK_EQUAL(replay.fields()[i].bitSize, fields[i].bitSize);
+			CHECK_EQUAL(replay.fields()[i].logicalMax, fields[i].logicalMax);
+		}
+
+		// Played back twice, to cover rewinding.
+		for (int pass = 0; pass < 2; pass++)
+		{
+			uint8_t report[5];
+
+			for (const auto& expected : reports)
+			{
+				CHECK(replay.read(report));
+				CHECK(std::memcmp(report, expected.data(), sizeof(report)) == 0);
+			}
+
+			CHECK(!replay.read(report));
+			replay.rewind();
+		}
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(CaptureShorterThanLayout)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "triolinker-capture-short.bin").string();
+
+	const std::vector<std::vector<uint8_t>> reports = { { 0x01, 0x00, 0x80, 0x80, 0x00 } };
+
+	// A 16-bit X field starting in the last byte runs past the end of the report.
+	const std::vector<HidField> fields = { { 0x01, 0x30, 1, 32, 16, 0, 65535 } };
+
+	{
+		ListSource    list(reports);
+		CaptureWriter writer(path, list.reportLength(), fields);
+		CHECK(writer.good());
+	}
+
+	ReplaySource replay(path, false);
+	CHECK(replay.valid());
+
+	// The default [Buffers] layout ends at byte 4 and fits; one reading byte 5 doesn't.
+	MappingConfig mapping;
+	CHECK_EQUAL(DecodePlan(mapping).reportLength(), 5u);
+	CHECK(DecodePlan(mapping).reportLength() <= replay.reportLength());
+
+	mapping.buffer_rz = 5;
+	CHECK(DecodePlan(mapping).reportLength() > replay.reportLength());
+
+	CHECK_EQUAL(DecodePlan(MappingConfig(), replay.fields()).reportLength(), 6u);
+	CHECK(DecodePlan(MappingConfig(), replay.fields()).reportLength() > replay.reportLength());
+
+	std::filesystem::remove(path);
+}
+
+TEST(CaptureInvalidFile)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "triolinker-capture-invalid.bin").string();
+
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << "not a capture";
+	}
+
+	ReplaySource replay(path, false);
+	CHECK(!replay.valid());
+
+	std::filesystem::remove(path);
+}
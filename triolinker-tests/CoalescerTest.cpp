@@ -0,0 +1,62 @@
+/**
+ * triolinker-vjoy
+ * Coalescer tests.
+ */
+
+#include "Coalescer.hpp"
+#include "Test.hpp"
+
+/**
+ * @param buttons Button mask.
+ * @return A state with only the given buttons held.
+ */
+static JoyState buttons(uint32_t buttons)
+{
+	JoyState state;
+	state.buttons = buttons;
+	return state;
+}
+
+TEST(CoalescerTapInSkippedReports)
+{
+	Coalescer coalescer;
+	JoyState  pulse;
+
+	// Button 1 is pressed and released again within the reports that are skipped.
+	coalescer.skip(buttons(0x0));
+	coalescer.skip(buttons(0x1));
+	coalescer.skip(buttons(0x0));
+
+	CHECK(coalescer.flush(buttons(0x0), pulse));
+	CHECK_EQUAL(pulse.buttons, 0x1u);
+	CHECK_EQUAL(coalescer.coalesced(), 3u);
+
+	// Nothing is left over for the next report.
+	CHECK(!coalescer.flush(buttons(0x0), pulse));
+}
+
+TEST(CoalescerReleaseInSkippedReports)
+{
+	Coalescer coalescer;
+	JoyState  pulse;
+
+	CHECK(!coalescer.flush(buttons(0x2), pulse));
+
+	// Button 2 is let go briefly while held.
+	coalescer.skip(buttons(0x0));
+	coalescer.skip(buttons(0x2));
+
+	CHECK(coalescer.flush(buttons(0x2), pulse));
+	CHECK_EQUAL(pulse.buttons, 0x0u);
+}
+
+TEST(CoalescerNoPulseForVisibleEdge)
+{
+	Coalescer coalescer;
+	JoyState  pulse;
+
+	// A press that is still held in the newest report reaches the output anyway.
+	coalescer.skip(buttons(0x4));
+
+	CHECK(!coalescer.flush(buttons(0x4), pulse));
+}
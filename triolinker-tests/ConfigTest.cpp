@@ -0,0 +1,50 @@
+/**
+ * triolinker-vjoy
+ * Configuration tests.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "Config.hpp"
+#include "IniFile.hpp"
+#include "Test.hpp"
+
+/**
+ * @param text Contents of config.ini.
+ * @return Feeder settings read from it.
+ */
+static FeederConfig readText(const std::string& text)
+{
+	std::istringstream stream(text);
+	return readConfig(IniFile(stream));
+}
+
+TEST(ConfigDeviceFile)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "triolinker-config-test.ini").string();
+
+	{
+		std::ofstream file(path);
+		file << "[General]\nOutputMode=Frame\n";
+	}
+
+	const FeederConfig settings = readText("[Device1]\nConfig=" + path + "\n[Device2]\n");
+	std::filesystem::remove(path);
+
+	CHECK_EQUAL(settings.devices.size(), 2u);
+	CHECK(settings.devices[0].outputMode == OutputMode::Frame);
+	CHECK(settings.devices[0].missingConfig.empty());
+	CHECK(settings.devices[1].outputMode == OutputMode::Delta);
+}
+
+TEST(ConfigMissingDeviceFile)
+{
+	const FeederConfig settings = readText("[Device1]\nConfig=triolinker-missing.ini\n[Device2]\n");
+
+	// The device with the missing file is flagged rather than quietly using the defaults.
+	CHECK_EQUAL(settings.devices.size(), 2u);
+	CHECK_EQUAL(settings.devices[0].missingConfig, "triolinker-missing.ini");
+	CHECK(settings.devices[1].missingConfig.empty());
+}
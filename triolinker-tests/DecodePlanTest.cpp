@@ -0,0 +1,195 @@
+/**
+ * triolinker-vjoy
+ * DecodePlan tests.
+ */
+
+#include "DecodePlan.hpp"
+#include "Test.hpp"
+
+/**
+ * @return The default mapping with every axis ranging from 0 to 0x8000, as vJoy reports it.
+ */
+static MappingConfig vJoyMapping()
+{
+	MappingConfig mapping;
+
+	for (auto& range : mapping.axisRanges)
+	{
+		range = { 0, 0x8000 };
+	}
+
+	return mapping;
+}
+
+TEST(DecodePlanByteAxes)
+{
+	MappingConfig mapping = vJoyMapping();
+	mapping.buffer_z = 5;
+
+	const DecodePlan plan(mapping);
+
+	uint8_t  report[8] {};
+	JoyState state;
+
+	report[3] = 0x00;
+	report[4] = 0xFF;
+	report[5] = 0x80;
+	plan.decode(report, state);
+
+	CHECK_EQUAL(state.axes[0], 0);
+	CHECK_EQUAL(state.axes[1], 0x8000);
+	CHECK_EQUAL(state.axes[2], (0x80 * 0x8000 + 127) / 255);
+	CHECK_EQUAL(state.pov, -1);
+}
+
+TEST(DecodePlanAxisScaling)
+{
+	MappingConfig mapping = vJoyMapping();
+	mapping.unlinkDpad    = false;
+	mapping.axisRanges[0] = { -32768, 32767 };
+	mapping.axisRanges[1] = { 1, 101 };
+
+	const DecodePlan plan(mapping);
+
+	uint8_t  report[8] {};
+	JoyState state;
+
+	report[3] = 0x00;
+	report[4] = 0x00;
+	plan.decode(report, state);
+	CHECK_EQUAL(state.axes[0], -32768);
+	CHECK_EQUAL(state.axes[1], 1);
+
+	report[3] = 0xFF;
+	report[4] = 0xFF;
+	plan.decode(report, state);
+	CHECK_EQUAL(state.axes[0], 32767);
+	CHECK_EQUAL(state.axes[1], 101);
+
+	// Rounded to the nearest value: 1 + 51 * 100 / 255 = 21.
+	report[4] = 51;
+	plan.decode(report, state);
+	CHECK_EQUAL(state.axes[1], 21);
+}
+
+TEST(DecodePlanButtons)
+{
+	const DecodePlan plan(vJoyMapping());
+
+	uint8_t  report[8] {};
+	JoyState state;
+
+	// Buttons1 is buffer 1; Buttons2 shares buffer 2 with the D-Pad, whose bits are left out.
+	report[1] = 0x81;
+	report[2] = 0x0F;
+	plan.decode(report, state);
+
+	CHECK_EQUAL(state.buttons, 0x0F81u);
+
+	report[1] = 0x00;
+	report[2] = 0x10;
+	plan.decode(report, state);
+
+	CHECK_EQUAL(state.buttons, 0u);
+	CHECK_EQUAL(state.pov, 0);
+}
+
+TEST(DecodePlanHatTable)
+{
+	const MappingConfig mapping = vJoyMapping();
+	const DecodePlan    plan(mapping);
+
+	const std::pair<uint8_t, int32_t> directions[] = {
+		{ mapping.hat_up, 0 },       { mapping.hat_up_right, 4500 },    { mapping.hat_right, 9000 },
+		{ mapping.hat_down_right, 13500 }, { mapping.hat_down, 18000 }, { mapping.hat_down_left, 22500 },
+		{ mapping.hat_left, 27000 }, { mapping.hat_up_left, 31500 },    { mapping.hat_center, -1 },
+		{ 0x50, -1 } // not a direction
+	};
+
+	uint8_t  report[8] {};
+	JoyState state;
+
+	for (const auto& [value, pov] : directions)
+	{
+		report[2] = value;
+		plan.decode(report, state);
+		CHECK_EQUAL(state.pov, pov);
+	}
+}
+
+TEST(DecodePlanUnlinkedDpad)
+{
+	MappingConfig mapping = vJoyMapping();
+	mapping.defaultX      = 25.0f;
+	mapping.defaultY      = 75.0f;
+
+	const DecodePlan plan(mapping);
+
+	uint8_t  report[8] {};
+	JoyState state;
+
+	report[2] = mapping.hat_left;
+	report[3] = 0xFF;
+	report[4] = 0xFF;
+	plan.decode(report, state);
+
+	CHECK_EQUAL(state.axes[0], 0x2000);
+	CHECK_EQUAL(state.axes[1], 0x6000);
+	CHECK_EQUAL(state.pov, 27000);
+}
+
+TEST(DecodePlanFields)
+{
+	MappingConfig mapping = vJoyMapping();
+	mapping.unlinkDpad    = false;
+
+	// Report ID 1, X as unsigned 16 bits, Y as signed 16 bits, 10-bit Z straddling
+	// a byte boundary, two 1-bit buttons and a 4-bit hat in the upper nibble.
+	std::vector<HidField> fields = {
+		{ 0x01, 0x30, 1, 8, 16, 0, 0x8000 },
+		{ 0x01, 0x31, 1, 24, 16, -32768, 32767 },
+		{ 0x01, 0x32, 1, 44, 10, 0, 1023 },
+		{ 0x09, 0x01, 1, 56, 1, 0, 1 },
+		{ 0x09, 0x03, 1, 58, 1, 0, 1 },
+		{ 0x01, 0x39, 1, 60, 4, 0, 7 },
+	};
+
+	const DecodePlan plan(mapping, fields);
+
+	uint8_t  report[8] {};
+	JoyState state;
+
+	report[0] = 1;
+	report[1] = 0x34; // X = 0x1234
+	report[2] = 0x12;
+	report[3] = 0xFF; // Y = 32767
+	report[4] = 0x7F;
+	report[5] = 0xF0; // Z = 1023: bits 4-7 of byte 5 and 0-5 of byte 6
+	report[6] = 0x3F;
+	report[7] = 0x25; // buttons 1 and 3 down, hat 2 (east)
+	plan.decode(report, state);
+
+	CHECK_EQUAL(state.axes[0], 0x1234);
+	CHECK_EQUAL(state.axes[1], 0x8000);
+	CHECK_EQUAL(state.axes[2], 0x8000);
+	CHECK_EQUAL(state.buttons, 0x5u);
+	CHECK_EQUAL(state.pov, 9000);
+
+	report[3] = 0x00; // Y = -32768
+	report[4] = 0x80;
+	report[5] = 0x00; // Z = 0, with the bits around it set
+	report[6] = 0xC0;
+	report[7] = 0x80; // hat 8 is outside its range: centered
+	plan.decode(report, state);
+
+	CHECK_EQUAL(state.axes[1], 0);
+	CHECK_EQUAL(state.axes[2], 0);
+	CHECK_EQUAL(state.buttons, 0u);
+	CHECK_EQUAL(state.pov, -1);
+
+	// Reports with another ID leave the state alone.
+	report[0] = 2;
+	state.buttons = 0xFF;
+	plan.decode(report, state);
+	CHECK_EQUAL(state.buttons, 0xFFu);
+}
@@ -0,0 +1,171 @@
+/**
+ * triolinker-vjoy
+ * Feeder tests.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+#include "Feeder.hpp"
+#include "Test.hpp"
+
+/**
+ * Always has a report ready, like a device that is never idle, and counts flushes.
+ */
+class ReadySource : public ReportSource
+{
+public:
+	size_t reportLength() const override
+	{
+		return 16;
+	}
+
+	bool read(uint8_t* report) override
+	{
+		std::fill(report, report + reportLength(), uint8_t(0));
+		return true;
+	}
+
+	bool ready() const override
+	{
+		return true;
+	}
+
+	void flush() override
+	{
+		m_flushes++;
+	}
+
+	size_t flushes() const
+	{
+		return m_flushes;
+	}
+
+protected:
+	size_t m_flushes = 0;
+};
+
+/**
+ * Discards every state.
+ */
+class DiscardSink : public OutputSink
+{
+public:
+	void commit(const JoyState& /*state*/) override
+	{
+	}
+};
+
+/**
+ * Plays back a list of reports, each ready as soon as the one before it was read.
+ */
+class QueuedSource : public ReportSource
+{
+public:
+	explicit QueuedSource(std::deque<std::vector<uint8_t>> reports)
+		: m_reports(std::move(reports))
+	{
+	}
+
+	size_t reportLength() const override
+	{
+		return 16;
+	}
+
+	bool read(uint8_t* report) override
+	{
+		if (m_reports.empty())
+		{
+			return false;
+		}
+
+		std::copy(m_reports.front().begin(), m_reports.front().end(), report);
+		m_reports.pop_front();
+		return true;
+	}
+
+	bool ready() const override
+	{
+		return !m_reports.empty();
+	}
+
+protected:
+	std::deque<std::vector<uint8_t>> m_reports;
+};
+
+/**
+ * Records the buttons of every committed state.
+ */
+class ButtonSink : public OutputSink
+{
+public:
+	void commit(const JoyState& state) override
+	{
+		buttons.push_back(state.buttons);
+	}
+
+	std::vector<uint32_t> buttons;
+};
+
+/**
+ * @param buttons1 Value of the first button byte in the default layout.
+ * @return A report with the hat centered.
+ */
+static std::vector<uint8_t> report(uint8_t buttons1)
+{
+	std::vector<uint8_t> report(16);
+	report[1] = buttons1;
+	return report;
+}
+
+TEST(FeederStepWaitIsNoStall)
+{
+	const DecodePlan plan { MappingConfig() };
+	ReadySource      source;
+	DiscardSink      sink;
+	FeederOptions    options;
+
+	options.staleAfter = 1'000'000;
+
+	Feeder feeder(plan, source, sink, options);
+
+	CHECK(feeder.step());
+
+	// Waiting for the next report to arrive doesn't make it stale.
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	feeder.wake();
+	CHECK(feeder.step());
+	CHECK_EQUAL(source.flushes(), 0u);
+	CHECK_EQUAL(feeder.flushes(), 0u);
+
+	// Being held up between two reports that were both ready does.
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	CHECK(feeder.step());
+	CHECK_EQUAL(source.flushes(), 1u);
+	CHECK_EQUAL(feeder.flushes(), 1u);
+}
+
+TEST(FeederResetForgetsButtons)
+{
+	const DecodePlan plan { MappingConfig() };
+	QueuedSource       before({ report(0x01) });
+	QueuedSource       after({ report(0x01), report(0x00) });
+	ButtonSink       sink;
+	FeederOptions    options;
+
+	options.coalesce = true;
+
+	Feeder feeder(plan, before, sink, options);
+
+	// Button 1 is held when the device goes away.
+	CHECK(feeder.step());
+	CHECK(!feeder.step());
+	feeder.reset();
+
+	// After reconnecting it is tapped within reports that are coalesced, which still reaches the output.
+	feeder.attach(after);
+	CHECK(feeder.step());
+	CHECK(sink.buttons == std::vector<uint32_t>({ 0x1, 0x0, 0x1, 0x0 }));
+}
@@ -0,0 +1,59 @@
+/**
+ * triolinker-vjoy
+ * LatencyHistogram tests.
+ */
+
+#include "LatencyHistogram.hpp"
+#include "Test.hpp"
+
+TEST(LatencyHistogramEmpty)
+{
+	const LatencyHistogram histogram;
+
+	CHECK_EQUAL(histogram.count(), 0u);
+	CHECK_EQUAL(histogram.percentile(50.0), 0u);
+}
+
+TEST(LatencyHistogramExactValues)
+{
+	LatencyHistogram histogram;
+
+	// Values below 64 ns have a bucket each.
+	for (uint64_t value = 1; value <= 10; value++)
+	{
+		histogram.record(value);
+	}
+
+	CHECK_EQUAL(histogram.count(), 10u);
+	CHECK_EQUAL(histogram.percentile(50.0), 5u);
+	CHECK_EQUAL(histogram.percentile(90.0), 9u);
+	CHECK_EQUAL(histogram.percentile(100.0), 10u);
+	CHECK_EQUAL(histogram.max(), 10u);
+}
+
+TEST(LatencyHistogramPercentiles)
+{
+	LatencyHistogram histogram;
+
+	for (uint64_t value = 1; value <= 100000; value++)
+	{
+		histogram.record(value * 1000);
+	}
+
+	// Bucket upper bounds are at most ~3% above the exact value, and never below it.
+	const std::pair<double, uint64_t> percentiles[] = {
+		{ 50.0, 50'000'000 }, { 99.0, 99'000'000 }, { 99.9, 99'900'000 }
+	};
+
+	for (const auto& [percent, exact] : percentiles)
+	{
+		const uint64_t value = histogram.percentile(percent);
+
+		CHECK(value >= exact);
+		CHECK(value <= exact + exact / 32);
+	}
+
+	// Never more than the largest value recorded.
+	CHECK_EQUAL(histogram.percentile(100.0), 100'000'000u);
+	CHECK_EQUAL(histogram.max(), 100'000'000u);
+}
@@ -0,0 +1,94 @@
+/**
+ * triolinker-vjoy
+ * ProbePool tests.
+ */
+
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "ParallelProbe.hpp"
+#include "Test.hpp"
+
+using namespace std::chrono_literals;
+
+TEST(ProbePoolEnumerationOrder)
+{
+	ProbePool pool(4);
+
+	// Later candidates answer first, and every odd one matches.
+	const auto probe = [](size_t index)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10 * (6 - index)));
+		return index % 2 == 1;
+	};
+
+	CHECK(pool.probe(6, probe, 4, 1000ms, true) == std::vector<size_t>({ 1, 3, 5 }));
+
+	// Looking for one match still gives the first one, not the quickest.
+	CHECK(pool.probe(6, probe, 4, 1000ms, false) == std::vector<size_t>({ 1 }));
+}
+
+TEST(ProbePoolTimeout)
+{
+	ProbePool pool(4);
+
+	// Candidate 0 doesn't answer in time; the others are still checked meanwhile.
+	const auto matches = pool.probe(4, [](size_t index)
+	{
+		if (index == 0)
+		{
+			std::this_thread::sleep_for(200ms);
+		}
+
+		return true;
+	}, 2, 50ms, true);
+
+	CHECK(matches == std::vector<size_t>({ 1, 2, 3 }));
+}
+
+TEST(ProbePoolAllThreadsStuck)
+{
+	ProbePool pool(2);
+
+	// Once both threads are left waiting on candidates, the rest are given up on too.
+	const auto start   = std::chrono::steady_clock::now();
+	const auto matches = pool.probe(5, [](size_t index)
+	{
+		if (index < 2)
+		{
+			std::this_thread::sleep_for(300ms);
+		}
+
+		return true;
+	}, 2, 50ms, true);
+
+	CHECK(matches.empty());
+	CHECK(std::chrono::steady_clock::now() - start < 250ms);
+}
+
+TEST(ProbePoolStuckProbeOnDestroy)
+{
+	// Shared with the probe, which is still running when the test ends.
+	const auto answer = std::make_shared<std::promise<bool>>();
+	const auto result = answer->get_future().share();
+	const auto start  = std::chrono::steady_clock::now();
+
+	{
+		ProbePool pool(2);
+
+		// Candidate 0 never answers while the pool exists.
+		const auto matches = pool.probe(2, [result](size_t index)
+		{
+			return index == 0 ? result.get() : true;
+		}, 2, 50ms, true);
+
+		CHECK(matches == std::vector<size_t>({ 1 }));
+	}
+
+	// Destroying the pool didn't wait for it.
+	CHECK(std::chrono::steady_clock::now() - start < 1000ms);
+
+	// The detached thread still finishes cleanly once the probe returns.
+	answer->set_value(true);
+}
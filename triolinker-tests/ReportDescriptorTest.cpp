@@ -0,0 +1,113 @@
+/**
+ * triolinker-vjoy
+ * ReportDescriptor tests.
+ */
+
+#include <iterator>
+
+#include "ReportDescriptor.hpp"
+#include "Test.hpp"
+
+TEST(ReportDescriptorJoystick)
+{
+	const uint8_t descriptor[] = {
+		0x05, 0x01,       // Usage Page (Generic Desktop)
+		0x09, 0x04,       // Usage (Joystick)
+		0xA1, 0x01,       // Collection (Application)
+		0x85, 0x01,       //   Report ID (1)
+		0x09, 0x30,       //   Usage (X)
+		0x09, 0x31,       //   Usage (Y)
+		0x16, 0x00, 0xFE, //   Logical Minimum (-512)
+		0x26, 0xFF, 0x01, //   Logical Maximum (511)
+		0x75, 0x0A,       //   Report Size (10)
+		0x95, 0x02,       //   Report Count (2)
+		0x81, 0x02,       //   Input (Data, Variable, Absolute)
+		0x09, 0x39,       //   Usage (Hat Switch)
+		0x15, 0x00,       //   Logical Minimum (0)
+		0x25, 0x07,       //   Logical Maximum (7)
+		0x75, 0x04,       //   Report Size (4)
+		0x95, 0x01,       //   Report Count (1)
+		0x81, 0x42,       //   Input (Data, Variable, Absolute, Null State)
+		0x05, 0x09,       //   Usage Page (Button)
+		0x19, 0x01,       //   Usage Minimum (1)
+		0x29, 0x03,       //   Usage Maximum (3)
+		0x25, 0x01,       //   Logical Maximum (1)
+		0x75, 0x01,       //   Report Size (1)
+		0x95, 0x03,       //   Report Count (3)
+		0x81, 0x02,       //   Input (Data, Variable, Absolute)
+		0x95, 0x05,       //   Report Count (5)
+		0x81, 0x03,       //   Input (Constant): padding
+		0x05, 0x01,       //   Usage Page (Generic Desktop)
+		0x09, 0x32,       //   Usage (Z)
+		0x26, 0xFF, 0x00, //   Logical Maximum (255)
+		0x75, 0x08,       //   Report Size (8)
+		0x95, 0x01,       //   Report Count (1)
+		0x91, 0x02,       //   Output (Data, Variable, Absolute): not an input
+		0xC0              // End Collection
+	};
+
+	const ReportLayout layout = parseReportDescriptor(descriptor, std::size(descriptor));
+
+	CHECK(layout.reportIds);
+	CHECK_EQUAL(layout.fields.size(), 6u);
+
+	// 20 + 4 + 3 + 5 bits after the report ID byte.
+	CHECK_EQUAL(layout.inputLength, 5u);
+
+	if (layout.fields.size() != 6)
+	{
+		return;
+	}
+
+	const HidField expected[] = {
+		{ 0x01, 0x30, 1, 8, 10, -512, 511 },
+		{ 0x01, 0x31, 1, 18, 10, -512, 511 },
+		{ 0x01, 0x39, 1, 28, 4, 0, 7 },
+		{ 0x09, 0x01, 1, 32, 1, 0, 1 },
+		{ 0x09, 0x02, 1, 33, 1, 0, 1 },
+		{ 0x09, 0x03, 1, 34, 1, 0, 1 },
+	};
+
+	for (size_t i = 0; i < std::size(expected); i++)
+	{
+		const HidField& field = layout.fields[i];
+
+		CHECK_EQUAL(field.usagePage, expected[i].usagePage);
+		CHECK_EQUAL(field.usage, expected[i].usage);
+		CHECK_EQUAL(field.reportId, expected[i].reportId);
+		CHECK_EQUAL(field.bitOffset, expected[i].bitOffset);
+		CHECK_EQUAL(field.bitSize, expected[i].bitSize);
+		CHECK_EQUAL(field.logicalMin, expected[i].logicalMin);
+		CHECK_EQUAL(field.logicalMax, expected[i].logicalMax);
+	}
+}
+
+TEST(ReportDescriptorUnsignedMaximum)
+{
+	const uint8_t descriptor[] = {
+		0x05, 0x01, // Usage Page (Generic Desktop)
+		0x09, 0x30, // Usage (X)
+		0x15, 0x00, // Logical Minimum (0)
+		0x25, 0xFF, // Logical Maximum (255, written as -1)
+		0x75, 0x08, // Report Size (8)
+		0x95, 0x01, // Report Count (1)
+		0x81, 0x02, // Input (Data, Variable, Absolute)
+	};
+
+	const ReportLayout layout = parseReportDescriptor(descriptor, std::size(descriptor));
+
+	CHECK(!layout.reportIds);
+	CHECK_EQUAL(layout.inputLength, 2u);
+	CHECK(layout.fields.size() == 1 && layout.fields[0].logicalMax == 255);
+}
+
+TEST(ReportDescriptorTruncated)
+{
+	// Logical Maximum with one of its two bytes missing.
+	const uint8_t descriptor[] = { 0x05, 0x01, 0x09, 0x30, 0x26, 0xFF };
+
+	const ReportLayout layout = parseReportDescriptor(descriptor, std::size(descriptor));
+
+	CHECK(layout.fields.empty());
+	CHECK_EQUAL(layout.inputLength, 1u);
+}
@@ -0,0 +1,107 @@
+/**
+ * triolinker-vjoy
+ * ReportQueue tests.
+ */
+
+#include <cstring>
+#include <thread>
+
+#include "ReportQueue.hpp"
+#include "Test.hpp"
+
+TEST(ReportQueueWraparound)
+{
+	// Rounded up to 4 slots.
+	ReportQueue queue(3, 2);
+
+	uint8_t next = 0;
+	uint8_t expected = 0;
+
+	for (int round = 0; round < 10; round++)
+	{
+		for (int i = 0; i < 3; i++, next++)
+		{
+			const uint8_t report[2] = { next, static_cast<uint8_t>(~next) };
+			queue.push(report, next * 10u);
+		}
+
+		CHECK_EQUAL(queue.size(), 3u);
+
+		for (int i = 0; i < 3; i++, expected++)
+		{
+			const uint8_t* report = queue.wait();
+
+			CHECK(report != nullptr);
+			CHECK_EQUAL(report[0], expected);
+			CHECK_EQUAL(report[1], static_cast<uint8_t>(~expected));
+			CHECK_EQUAL(queue.timestamp(), expected * 10u);
+
+			queue.pop();
+		}
+
+		CHECK_EQUAL(queue.size(), 0u);
+	}
+}
+
+TEST(ReportQueueCapacity)
+{
+	ReportQueue queue(3, 1);
+
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		queue.push(&i);
+	}
+
+	CHECK_EQUAL(queue.size(), 4u);
+}
+
+TEST(ReportQueueClose)
+{
+	ReportQueue   queue(4, 1);
+	const uint8_t report = 7;
+
+	queue.push(&report);
+	queue.close();
+
+	// What was queued before closing is still delivered.
+	const uint8_t* first = queue.wait();
+	CHECK(first != nullptr && *first == 7);
+	queue.pop();
+
+	CHECK(queue.wait() == nullptr);
+}
+
+TEST(ReportQueueThreads)
+{
+	constexpr uint32_t COUNT = 100000;
+
+	ReportQueue queue(8, sizeof(uint32_t));
+
+	std::thread producer([&queue]
+	{
+		for (uint32_t i = 0; i < COUNT; i++)
+		{
+			queue.push(reinterpret_cast<const uint8_t*>(&i), i);
+		}
+
+		queue.close();
+	});
+
+	uint32_t received = 0;
+	bool     ordered  = true;
+
+	while (const uint8_t* report = queue.wait())
+	{
+		uint32_t value;
+		std::memcpy(&value, report, sizeof(value));
+
+		ordered = ordered && value == received && queue.timestamp() == received;
+		++received;
+		queue.pop();
+	}
+
+	producer.join();
+
+	CHECK(ordered);
+	CHECK_EQUAL(received, COUNT);
+}
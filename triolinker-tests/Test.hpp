@@ -0,0 +1,64 @@
+/**
+ * triolinker-vjoy
+ * Minimal test registry and checks.
+ */
+
+#ifndef TEST_HPP
+#define TEST_HPP
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * A registered test.
+ */
+struct TestCase
+{
+	const char* name;
+	void (*function)();
+};
+
+std::vector<TestCase>& testCases();
+void testFailed(const char* file, int line, const std::string& message);
+
+/**
+ * Adds a test to testCases() before main() runs.
+ */
+struct TestRegistration
+{
+	TestRegistration(const char* name, void (*function)())
+	{
+		testCases().push_back({ name, function });
+	}
+};
+
+#define TEST(name) \
+	static void test_##name(); \
+	static const TestRegistration registration_##name(#name, test_##name); \
+	static void test_##name()
+
+// A failed check is reported and the test carries on, so one run shows every failure.
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			testFailed(__FILE__, __LINE__, #condition); \
+		} \
+	} while (false)
+
+#define CHECK_EQUAL(actual, expected) \
+	do \
+	{ \
+		const auto& actual_   = (actual); \
+		const auto& expected_ = (expected); \
+		if (!(actual_ == expected_)) \
+		{ \
+			std::ostringstream message_; \
+			message_ << #actual " == " #expected " (got " << actual_ << ", expected " << expected_ << ")"; \
+			testFailed(__FILE__, __LINE__, message_.str()); \
+		} \
+	} while (false)
+
+#endif /* TEST_HPP */
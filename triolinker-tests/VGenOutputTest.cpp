@@ -0,0 +1,193 @@
+/**
+ * triolinker-vjoy
+ * vJoy and vXbox output tests, run against the vGen mock.
+ */
+
+#include "Test.hpp"
+#include "vGenMock.hpp"
+#include "VJoyOutput.hpp"
+#include "VXboxOutput.hpp"
+
+/**
+ * Acquires a mocked device for the length of a test.
+ */
+class MockDevice
+{
+public:
+	MockDevice(UINT id, DevType type, bool discretePov = false)
+	{
+		mockSetDiscretePov(discretePov);
+		AcquireDev(id, type, &m_hDev);
+	}
+
+	~MockDevice()
+	{
+		RelinquishDev(m_hDev);
+		mockSetDiscretePov(false);
+	}
+
+	HDEVICE handle() const
+	{
+		return m_hDev;
+	}
+
+protected:
+	HDEVICE m_hDev = INVALID_DEV;
+};
+
+/**
+ * @return Calls recorded since the last call, one "function device index value" line each.
+ * Clearing the trace also resets the device state, so check the state first.
+ */
+static std::string takeCalls()
+{
+	std::ostringstream calls;
+
+	for (const auto& call : mockTrace())
+	{
+		calls << mockFunctionName(call.function) << ' ' << call.device << ' ' << call.index << ' ' << call.value << '\n';
+	}
+
+	mockClearTrace();
+	return calls.str();
+}
+
+/**
+ * @return A centered state with the given buttons held.
+ */
+static JoyState held(uint32_t buttons, int32_t pov = -1)
+{
+	JoyState state;
+	state.buttons = buttons;
+	state.pov     = pov;
+	return state;
+}
+
+TEST(VJoyDeltaSendsOnlyChanges)
+{
+	MockDevice device(1, DevType::vJoy);
+	VJoyOutput output(device.handle(), OutputMode::Delta);
+	JoyState   state = held(0x1);
+
+	takeCalls();
+
+	// The first state sends every control.
+	output.commit(state);
+	CHECK_EQUAL(mockTrace().size(), AXIS_COUNT + BUTTON_COUNT + 1);
+	CHECK_EQUAL(mockState(device.handle()).buttons, 0x1u);
+	takeCalls();
+
+	output.commit(state);
+	CHECK_EQUAL(takeCalls(), "");
+
+	state.buttons = 0x5;
+	output.commit(state);
+	CHECK_EQUAL(takeCalls(), "SetBtn 1 3 1\n");
+
+	state.axes[1] = 0x4000;
+	state.pov     = 9000;
+	output.commit(state);
+	CHECK_EQUAL(takeCalls(), "SetAxis 1 49 16384\nSetContPov 1 1 9000\n");
+}
+
+TEST(VJoyDeltaDiscretePov)
+{
+	MockDevice device(2, DevType::vJoy, true);
+	VJoyOutput output(device.handle(), OutputMode::Delta);
+
+	output.commit(held(0x0, 9000));
+	CHECK_EQUAL(mockState(device.handle()).pov, 1u);
+	takeCalls();
+
+	// 91 degrees still rounds to east.
+	output.commit(held(0x0, 9100));
+	CHECK_EQUAL(takeCalls(), "");
+
+	output.commit(held(0x0, 18000));
+	CHECK_EQUAL(takeCalls(), "SetDiscPov 2 1 2\n");
+
+	output.commit(held(0x0));
+	CHECK_EQUAL(takeCalls(), "SetDiscPov 2 1 -1\n");
+}
+
+TEST(VJoyFrameSendsOneUpdate)
+{
+	MockDevice device(1, DevType::vJoy);
+	VJoyOutput output(device.handle(), OutputMode::Frame);
+
+	takeCalls();
+
+	output.commit(held(0x3, 27000));
+	CHECK_EQUAL(mockState(device.handle()).buttons, 0x3u);
+	CHECK_EQUAL(takeCalls(), "UpdateVJD 1 27000 3\n");
+
+	output.commit(held(0x3, 27000));
+	CHECK_EQUAL(takeCalls(), "");
+
+	output.commit(held(0x2, 27000));
+	CHECK_EQUAL(takeCalls(), "UpdateVJD 1 27000 2\n");
+}
+
+TEST(VJoyFrameDiscretePov)
+{
+	MockDevice device(1, DevType::vJoy, true);
+	VJoyOutput output(device.handle(), OutputMode::Frame);
+
+	takeCalls();
+
+	// The direction goes in the low nibble, the other POVs stay centered.
+	output.commit(held(0x0, 9000));
+	CHECK_EQUAL(mockState(device.handle()).pov, 1u);
+	CHECK_EQUAL(takeCalls(), "UpdateVJD 1 4294967281 0\n");
+
+	output.commit(held(0x0));
+	CHECK_EQUAL(mockState(device.handle()).pov, 0xFFFFFFFFu);
+	CHECK_EQUAL(takeCalls(), "UpdateVJD 1 4294967295 0\n");
+}
+
+TEST(VJoySeparateDevices)
+{
+	MockDevice first(1, DevType::vJoy);
+	MockDevice second(2, DevType::vJoy);
+	VJoyOutput one(first.handle(), OutputMode::Frame);
+	VJoyOutput two(second.handle(), OutputMode::Frame);
+
+	one.commit(held(0x1));
+	two.commit(held(0x2));
+
+	CHECK_EQUAL(mockState(first.handle()).buttons, 0x1u);
+	CHECK_EQUAL(mockState(second.handle()).buttons, 0x2u);
+}
+
+TEST(VXboxSendsOnlyChanges)
+{
+	MockDevice  device(1, DevType::vXbox);
+	VXboxOutput output(device.handle(), XboxMapping());
+	JoyState    state;
+
+	takeCalls();
+
+	// The first state sends four sticks, two triggers, the D-Pad and every button.
+	output.commit(state);
+	CHECK_EQUAL(mockTrace().size(), XBOX_STICK_COUNT + 2 + 1 + XBOX_BUTTON_COUNT);
+	takeCalls();
+
+	output.commit(state);
+	CHECK_EQUAL(takeCalls(), "");
+
+	state.buttons = 0x1;
+	output.commit(state);
+	CHECK_EQUAL(mockState(device.handle()).xboxButtons, XBOX_A);
+	CHECK_EQUAL(takeCalls(), "SetButton 1 4096 1\n");
+
+	state.axes[0] = 1000;
+	state.pov     = 0;
+	output.commit(state);
+	CHECK_EQUAL(takeCalls(), "SetAxisLx 1 0 1000\nSetDpad 1 0 1\n");
+
+	// Resetting releases everything; the inverted Y axes rest at -1 while mapped.
+	output.reset();
+	CHECK_EQUAL(mockState(device.handle()).xboxButtons, 0);
+	CHECK_EQUAL(takeCalls(), "SetAxisLx 1 0 0\nSetAxisLy 1 0 0\nSetAxisRy 1 0 0\nSetTriggerL 1 0 0\nSetTriggerR 1 0 0\n"
+	                         "SetDpad 1 0 0\nSetButton 1 4096 0\n");
+}
@@ -0,0 +1,63 @@
+/**
+ * triolinker-vjoy
+ * Test runner. Runs every test, or only those named on the command line.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "Test.hpp"
+
+static size_t failures = 0;
+
+std::vector<TestCase>& testCases()
+{
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+/**
+ * Report a failed check.
+ * @param file Source file of the check.
+ * @param line Line of the check.
+ * @param message What was checked.
+ */
+void testFailed(const char* file, int line, const std::string& message)
+{
+	std::cout << file << ":" << line << ": check failed: " << message << std::endl;
+	++failures;
+}
+
+int main(int argc, char** argv)
+{
+	size_t run    = 0;
+	size_t failed = 0;
+
+	for (const auto& test : testCases())
+	{
+		bool selected = argc < 2;
+
+		for (int i = 1; i < argc; i++)
+		{
+			selected = selected || std::strcmp(argv[i], test.name) == 0;
+		}
+
+		if (!selected)
+		{
+			continue;
+		}
+
+		const size_t before = failures;
+		test.function();
+		++run;
+
+		if (failures != before)
+		{
+			std::cout << "FAILED " << test.name << std::endl;
+			++failed;
+		}
+	}
+
+	std::cout << run - failed << " of " << run << " tests passed." << std::endl;
+	return failed == 0 && run != 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/**
+ * triolinker-vjoy
+ * Raw report capture file format.
+ */
+
+#include "Capture.hpp"
+
+/**
+ * Create a capture file and write its header.
+ * @param path Capture file path.
+ * @param reportLength Size of every report in bytes.
+ * @param fields Input layout of the device, or empty if unknown.
+ */
+CaptureWriter::CaptureWriter(const std::string& path, size_t reportLength, const std::vector<HidField>& fields)
+	: m_stream(path, std::ios::binary | std::ios::trunc),
+	  m_reportLength(reportLength)
+{
+	CaptureHeader header;
+	header.reportLength = static_cast<uint16_t>(reportLength);
+	header.fieldCount   = static_cast<uint32_t>(fields.size());
+
+	m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& field : fields)
+	{
+		const CaptureField record {
+			field.usagePage, field.usage, field.reportId, field.bitSize,
+			field.bitOffset, field.logicalMin, field.logicalMax
+		};
+
+		m_stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+}
+
+/**
+ * @return True if the file is open and every write so far succeeded.
+ */
+bool CaptureWriter::good() const
+{
+	return m_stream.good();
+}
+
+/**
+ * Append a report.
+ * @param report Raw report of reportLength bytes.
+ * @param timestamp Nanoseconds since the first report.
+ */
+void CaptureWriter::write(const uint8_t* report, uint64_t timestamp)
+{
+	m_stream.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+	m_stream.write(reinterpret_cast<const char*>(report), static_cast<std::streamsize>(m_reportLength));
+}
+
+RecordingSource::RecordingSource(ReportSource& source, CaptureWriter& writer)
+	: m_source(&source),
+	  m_writer(writer)
+{
+}
+
+size_t RecordingSource::reportLength() const
+{
+	return m_source->reportLength();
+}
+
+bool RecordingSource::read(uint8_t* report)
+{
+	if (!m_source->read(report))
+	{
+		return false;
+	}
+
+	const auto now = std::chrono::steady_clock::now();
+
+	if (!m_started)
+	{
+		m_start   = now;
+		m_started = true;
+	}
+
+	m_writer.write(report, std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count());
+	return true;
+}
+
+bool RecordingSource::ready() const
+{
+	return m_source->ready();
+}
+
+/**
+ * Flushed reports are never read, so they aren't recorded either.
+ */
+void RecordingSource::flush()
+{
+	m_source->flush();
+}
+
+/**
+ * Continue recording from a new source, such as the device reopened after it was reconnected.
+ * Timestamps carry on from the first recorded report.
+ * @param source New source, with the same report length.
+ */
+void RecordingSource::attach(ReportSource& source)
+{
+	m_source = &source;
+}
+
+WaitHandle RecordingSource::waitHandle() const
+{
+	return m_source->waitHandle();
+}
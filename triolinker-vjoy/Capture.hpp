@@ -0,0 +1,92 @@
+/**
+ * triolinker-vjoy
+ * Raw report capture file format.
+ */
+
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "DecodePlan.hpp"
+#include "ReportSource.hpp"
+
+/*
+ * A capture file is a CaptureHeader, followed by fieldCount CaptureField
+ * records (the device's input layout, for Layout=Descriptor), followed by
+ * one record per report: a uint64_t timestamp in nanoseconds since the
+ * first report, then reportLength raw bytes. All values are little endian.
+ */
+
+constexpr uint32_t CAPTURE_MAGIC   = 0x4352'4C54; // "TLRC"
+constexpr uint16_t CAPTURE_VERSION = 1;
+
+struct CaptureHeader
+{
+	uint32_t magic        = CAPTURE_MAGIC;
+	uint16_t version      = CAPTURE_VERSION;
+	uint16_t reportLength = 0;
+	uint32_t fieldCount   = 0;
+	uint32_t reserved     = 0;
+};
+
+struct CaptureField
+{
+	uint16_t usagePage;
+	uint16_t usage;
+	uint8_t  reportId;
+	uint8_t  bitSize;
+	uint16_t bitOffset;
+	int32_t  logicalMin;
+	int32_t  logicalMax;
+};
+
+static_assert(sizeof(CaptureHeader) == 16, "capture header must be packed");
+static_assert(sizeof(CaptureField) == 16, "capture field must be packed");
+
+/**
+ * Appends reports to a capture file.
+ */
+class CaptureWriter
+{
+public:
+	CaptureWriter(const std::string& path, size_t reportLength, const std::vector<HidField>& fields);
+
+	bool good() const;
+	void write(const uint8_t* report, uint64_t timestamp);
+
+protected:
+	std::ofstream m_stream;
+	size_t        m_reportLength;
+};
+
+/**
+ * Passes reports through from another source, recording each one
+ * with the time its read completed.
+ */
+class RecordingSource : public ReportSource
+{
+public:
+	RecordingSource(ReportSource& source, CaptureWriter& writer);
+
+	size_t reportLength() const override;
+	bool read(uint8_t* report) override;
+	bool ready() const override;
+	void flush() override;
+	WaitHandle waitHandle() const override;
+
+	void attach(ReportSource& source);
+
+protected:
+	ReportSource*  m_source;
+	CaptureWriter& m_writer;
+	bool           m_started = false;
+
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#endif /* CAPTURE_HPP */
@@ -0,0 +1,64 @@
+/**
+ * triolinker-vjoy
+ * Latest-wins report coalescing.
+ */
+
+#include "Coalescer.hpp"
+
+/**
+ * Record a report that is being dropped because a newer one is already available.
+ * @param state Decoded state of the dropped report.
+ */
+void Coalescer::skip(const JoyState& state)
+{
+	m_pressed  |= state.buttons;
+	m_released |= ~state.buttons;
+	++m_coalesced;
+}
+
+/**
+ * Prepare to commit the newest state.
+ * A button that is in the same position in the last committed state and in
+ * the newest state, but changed in between, needs an extra state to be
+ * committed first or its edges would never reach the output.
+ * @param next Newest state about to be committed.
+ * @param pulse Receives the extra state, if one is needed.
+ * @return True if pulse must be committed before next.
+ */
+bool Coalescer::flush(const JoyState& next, JoyState& pulse)
+{
+	const uint32_t transient = (m_pressed & ~m_lastButtons & ~next.buttons) |
+	                           (m_released & m_lastButtons & next.buttons);
+
+	m_pressed     = 0;
+	m_released    = 0;
+	m_lastButtons = next.buttons;
+
+	if (!transient)
+	{
+		return false;
+	}
+
+	pulse = next;
+	pulse.buttons ^= transient;
+	return true;
+}
+
+/**
+ * Forget the skipped reports and the last flushed state, as the output was
+ * brought to rest with every button released. The count carries on.
+ */
+void Coalescer::reset()
+{
+	m_pressed     = 0;
+	m_released    = 0;
+	m_lastButtons = 0;
+}
+
+/**
+ * @return Total number of reports dropped by coalescing.
+ */
+uint64_t Coalescer::coalesced() const
+{
+	return m_coalesced;
+}
@@ -0,0 +1,33 @@
+/**
+ * triolinker-vjoy
+ * Latest-wins report coalescing.
+ */
+
+#ifndef COALESCER_HPP
+#define COALESCER_HPP
+
+#include <cstdint>
+
+#include "DecodePlan.hpp"
+
+/**
+ * Tracks button activity in reports that are skipped in favor of a newer one,
+ * so a press and release that both happen inside the skipped reports isn't lost.
+ */
+class Coalescer
+{
+public:
+	void skip(const JoyState& state);
+	bool flush(const JoyState& next, JoyState& pulse);
+	void reset();
+
+	uint64_t coalesced() const;
+
+protected:
+	uint32_t m_pressed     = 0; // buttons held in any skipped report
+	uint32_t m_released    = 0; // buttons released in any skipped report
+	uint32_t m_lastButtons = 0; // buttons of the last flushed state
+	uint64_t m_coalesced   = 0;
+};
+
+#endif /* COALESCER_HPP */
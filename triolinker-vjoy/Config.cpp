@@ -0,0 +1,293 @@
+/**
+ * triolinker-vjoy
+ * Feeder configuration.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "Config.hpp"
+
+/**
+ * Parse the source of an Xbox stick or trigger.
+ * @param value Axis name (X, Y, Z, RX, RY or RZ), optionally prefixed with - to invert it,
+ * or Button followed by a button number.
+ * @return Parsed source. Empty if the value is not recognized.
+ */
+static XboxSource parseXboxSource(const std::string& value)
+{
+	static const char* const axes[AXIS_COUNT] = { "X", "Y", "Z", "RX", "RY", "RZ" };
+
+	XboxSource result;
+
+	if (value.rfind("Button", 0) == 0)
+	{
+		const int button = std::atoi(value.c_str() + 6);
+		result.button = static_cast<int8_t>(button >= 1 && button <= static_cast<int>(BUTTON_COUNT) ? button - 1 : -1);
+		return result;
+	}
+
+	const bool        invert = !value.empty() && value[0] == '-';
+	const std::string name   = value.substr(invert ? 1 : 0);
+
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		if (name == axes[i])
+		{
+			result.axis   = static_cast<int8_t>(i);
+			result.invert = invert;
+			break;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Read an Xbox button assignment.
+ * @param config Contents of config.ini.
+ * @param key Xbox control name.
+ * @param def Default decoded button index, or -1.
+ * @return Decoded button index (0-based), or -1 if unassigned.
+ */
+static int8_t readXboxButton(const IniFile& config, const std::string& key, int8_t def)
+{
+	// Empty or 0 leaves the control unassigned.
+	const int button = std::atoi(config.getString("vXbox", key, std::to_string(def + 1)).c_str());
+	return static_cast<int8_t>(button >= 1 && button <= static_cast<int>(BUTTON_COUNT) ? button - 1 : -1);
+}
+
+/**
+ * Read the settings of a single device from [General], [Buffers], [DPad] and [vXbox].
+ * @param config Contents of config.ini, or of a device's own configuration file.
+ * @return Device settings.
+ */
+static DeviceConfig readDeviceConfig(const IniFile& config)
+{
+	DeviceConfig result;
+
+	result.device           = config.getString("General", "Device", "vJoy") == "vXbox" ? OutputDevice::VXbox : OutputDevice::VJoy;
+	result.outputMode       = config.getString("General", "OutputMode", "Delta") == "Frame" ? OutputMode::Frame : OutputMode::Delta;
+	result.descriptorLayout = config.getString("General", "Layout", "Buffers") == "Descriptor";
+	result.vendorID         = std::stol(config.getString("General", "VendorID", "7701"), nullptr, 16);
+	result.productID        = std::stol(config.getString("General", "ProductID", "0003"), nullptr, 16);
+
+	MappingConfig& mapping = result.mapping;
+	mapping.unlinkDpad    = config.getBool("General",  "UnlinkDPad",    true);
+	mapping.defaultX      = config.getFloat("General", "DefaultX",      50.1f);
+	mapping.defaultY      = config.getFloat("General", "DefaultY",      50.1f);
+	mapping.dPadAsButtons = config.getBool("General",  "DPadAsButtons", false);
+	mapping.buffer_x = config.getInt("Buffers", "X", 3);
+	mapping.buffer_y = config.getInt("Buffers", "Y", 4);
+	mapping.buffer_z = config.getInt("Buffers", "Z", 0);
+	mapping.buffer_rx = config.getInt("Buffers", "RX", 0);
+	mapping.buffer_ry = config.getInt("Buffers", "RY", 0);
+	mapping.buffer_rz = config.getInt("Buffers", "RZ", 0);
+	mapping.buffer_buttons1 = config.getInt("Buffers", "Buttons1", 1);
+	mapping.buffer_buttons2 = config.getInt("Buffers", "Buttons2", 2);
+	mapping.buffer_hat = config.getInt("Buffers", "DPad", 2);
+	mapping.hat_up = std::stol(config.getString("DPad", "DPad North", "0x10"), nullptr, 16);
+	mapping.hat_down = std::stol(config.getString("DPad", "DPad South", "0x40"), nullptr, 16);
+	mapping.hat_left = std::stol(config.getString("DPad", "DPad West", "0x80"), nullptr, 16);
+	mapping.hat_right = std::stol(config.getString("DPad", "DPad East", "0x20"), nullptr, 16);
+	mapping.hat_up_left = std::stol(config.getString("DPad", "DPad NorthWest", "0x90"), nullptr, 16);
+	mapping.hat_up_right = std::stol(config.getString("DPad", "DPad NorthEast", "0x30"), nullptr, 16);
+	mapping.hat_down_left = std::stol(config.getString("DPad", "DPad SouthWest", "0xC0"), nullptr, 16);
+	mapping.hat_down_right = std::stol(config.getString("DPad", "DPad SouthEast", "0x60"), nullptr, 16);
+	mapping.hat_center = std::stol(config.getString("DPad", "DPad Center", "0"), nullptr, 16);
+
+	static const char* const xboxSticks[XBOX_STICK_COUNT]   = { "LX", "LY", "RX", "RY" };
+	static const char* const xboxTriggers[2]                = { "LT", "RT" };
+	static const char* const xboxButtons[XBOX_BUTTON_COUNT] = { "A", "B", "X", "Y", "LB", "RB", "Back", "Start", "LThumb", "RThumb" };
+	static const char* const xboxDPad[4]                    = { "DPadUp", "DPadDown", "DPadLeft", "DPadRight" };
+
+	XboxMapping& xbox = result.xbox;
+
+	for (size_t i = 0; i < XBOX_STICK_COUNT; i++)
+	{
+		if (config.hasKey("vXbox", xboxSticks[i]))
+		{
+			xbox.sticks[i] = parseXboxSource(config.getString("vXbox", xboxSticks[i]));
+		}
+	}
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		if (config.hasKey("vXbox", xboxTriggers[i]))
+		{
+			xbox.triggers[i] = parseXboxSource(config.getString("vXbox", xboxTriggers[i]));
+		}
+	}
+
+	for (size_t i = 0; i < XBOX_BUTTON_COUNT; i++)
+	{
+		xbox.buttons[i] = readXboxButton(config, xboxButtons[i], xbox.buttons[i]);
+	}
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		xbox.dpad[i] = readXboxButton(config, xboxDPad[i], xbox.dpad[i]);
+	}
+
+	if (!result.descriptorLayout)
+	{
+		const int axisBuffers[AXIS_COUNT] = {
+			mapping.buffer_x,  mapping.buffer_y,  mapping.buffer_z,
+			mapping.buffer_rx, mapping.buffer_ry, mapping.buffer_rz
+		};
+
+		// Axes on buffer 0 are unassigned; sticks and triggers reading them would sit at one end.
+		for (XboxSource* source : { &xbox.sticks[0], &xbox.sticks[1], &xbox.sticks[2], &xbox.sticks[3], &xbox.triggers[0], &xbox.triggers[1] })
+		{
+			if (source->axis >= 0 && axisBuffers[source->axis] == 0)
+			{
+				source->axis = -1;
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Read the feeder settings.
+ * @param config Contents of config.ini.
+ * @return Feeder settings.
+ */
+FeederConfig readConfig(const IniFile& config)
+{
+	FeederConfig result;
+
+	result.hide         = config.getBool("General", "HideWindow", false);
+	result.reconnect    = config.getBool("General", "Reconnect", true);
+	result.pendingReads = std::max(config.getInt("General", "PendingReads", 0), 0);
+	result.inputBuffers = std::clamp(config.getInt("General", "InputBuffers", 0), 0, 512);
+	result.statsName    = config.getString("General", "StatsName", STATS_NAME);
+
+	FeederOptions& feeder = result.feeder;
+	feeder.coalesce        = config.getBool("General", "Coalesce", false);
+	feeder.latency         = config.getBool("General", "Latency", false);
+	feeder.staleAfter      = static_cast<uint64_t>(std::max(config.getInt("General", "FlushStale", 0), 0)) * 1'000'000;
+	feeder.threaded        = config.getBool("Threads", "Enabled", false);
+	feeder.queueLength     = std::max(config.getInt("Threads", "QueueLength", 64), 1);
+	feeder.reader.priority = config.getInt("Threads", "ReaderPriority", 0);
+	feeder.output.priority = config.getInt("Threads", "OutputPriority", 0);
+	feeder.reader.affinity = std::stoull(config.getString("Threads", "ReaderAffinity", "0"), nullptr, 16);
+	feeder.output.affinity = std::stoull(config.getString("Threads", "OutputAffinity", "0"), nullptr, 16);
+
+	result.workers = std::max(config.getInt("Threads", "Workers", 0), 0);
+
+	const DeviceConfig defaults = readDeviceConfig(config);
+
+	for (size_t i = 1; i <= MAX_DEVICES; i++)
+	{
+		const std::string section = "Device" + std::to_string(i);
+
+		if (!config.hasGroup(section))
+		{
+			continue;
+		}
+
+		// Each device takes its mapping from its own file if it has one, or from config.ini.
+		DeviceConfig device = defaults;
+
+		if (config.hasKeyNonEmpty(section, "Config"))
+		{
+			const std::string file = config.getString(section, "Config");
+			device = readDeviceConfig(IniFile(file));
+
+			// A file that can't be read would leave the device on the default mapping without a word.
+			if (!std::ifstream(file).is_open())
+			{
+				device.missingConfig = file;
+			}
+		}
+
+		if (config.hasKeyNonEmpty(section, "VendorID"))
+		{
+			device.vendorID = std::stol(config.getString(section, "VendorID"), nullptr, 16);
+		}
+
+		if (config.hasKeyNonEmpty(section, "ProductID"))
+		{
+			device.productID = std::stol(config.getString(section, "ProductID"), nullptr, 16);
+		}
+
+		device.path = config.getString(section, "Path", "");
+		device.id   = static_cast<unsigned int>(std::max(config.getInt(section, "ID", static_cast<int>(i)), 1));
+
+		result.devices.push_back(device);
+	}
+
+	if (result.devices.empty())
+	{
+		result.devices.push_back(defaults);
+	}
+
+	SimulatorConfig& simulator = result.simulator;
+	const std::string profile = config.getString("Simulator", "Profile", "Steady");
+	simulator.rate      = static_cast<uint32_t>(std::max(config.getInt("Simulator", "Rate", 1000), 1));
+	simulator.profile   = profile == "Jitter" ? SimulatorProfile::Jitter : profile == "Burst" ? SimulatorProfile::Burst : SimulatorProfile::Steady;
+	simulator.jitter    = static_cast<uint32_t>(std::max(config.getInt("Simulator", "Jitter", 100), 0));
+	simulator.burstSize = static_cast<uint32_t>(std::max(config.getInt("Simulator", "BurstSize", 8), 1));
+	simulator.reports   = std::stoull(config.getString("Simulator", "Reports", "0"));
+	simulator.script    = config.getString("Simulator", "Script", "");
+	simulator.seed      = static_cast<uint32_t>(config.getInt("Simulator", "Seed", 1));
+
+	result.output     = config.getString("Linux", "Output", result.output);
+	result.outputFile = config.getString("Linux", "OutputFile", result.outputFile);
+	result.deviceName = config.getString("Linux", "DeviceName", result.deviceName);
+
+	return result;
+}
+
+/**
+ * Parse the command line.
+ * --record <file>  Write every report read from the device to a capture file.
+ * --replay <file>  Read reports from a capture file instead of the device.
+ * --fast           Replay as fast as possible instead of in real time.
+ * --simulate       Read reports from the simulator configured in [Simulator] instead of the device.
+ * --stats [name]   Print a running feeder's counters once per second.
+ * @param argc Argument count.
+ * @param argv Arguments.
+ * @return Command line options. Unknown arguments are ignored.
+ */
+CommandLine parseCommandLine(int argc, char** argv)
+{
+	CommandLine result;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg(argv[i]);
+
+		if (arg == "--record" && i + 1 < argc)
+		{
+			result.record = argv[++i];
+		}
+		else if (arg == "--replay" && i + 1 < argc)
+		{
+			result.replay = argv[++i];
+		}
+		else if (arg == "--fast")
+		{
+			result.fast = true;
+		}
+		else if (arg == "--simulate")
+		{
+			result.simulate = true;
+		}
+		else if (arg == "--stats")
+		{
+			result.stats = true;
+
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				result.statsName = argv[++i];
+			}
+		}
+	}
+
+	return result;
+}
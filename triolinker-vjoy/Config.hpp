@@ -0,0 +1,89 @@
+/**
+ * triolinker-vjoy
+ * Feeder configuration.
+ */
+
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <string>
+#include <vector>
+
+#include "DecodePlan.hpp"
+#include "Feeder.hpp"
+#include "IniFile.hpp"
+#include "SimulatorSource.hpp"
+#include "Stats.hpp"
+#include "XboxMapping.hpp"
+
+enum class OutputMode
+{
+	Delta, // one SetDev* call per changed control
+	Frame, // one UpdateVJD call per changed report
+};
+
+enum class OutputDevice
+{
+	VJoy,
+	VXbox,
+};
+
+constexpr size_t MAX_DEVICES = 16;
+
+/**
+ * Settings of one input device and the virtual device it feeds.
+ */
+struct DeviceConfig
+{
+	int           vendorID         = 0x7701;
+	int           productID        = 0x0003;
+	std::string   path;                      // text the device path must contain, or empty for any
+	unsigned int  id               = 1;      // vJoy device ID or vXbox user index
+	OutputDevice  device           = OutputDevice::VJoy;
+	OutputMode    outputMode       = OutputMode::Delta;
+	bool          descriptorLayout = false;
+	MappingConfig mapping;
+	XboxMapping   xbox;
+	std::string   missingConfig;             // Config= file that couldn't be read, or empty
+};
+
+/**
+ * Feeder settings, as read from config.ini.
+ */
+struct FeederConfig
+{
+	bool            hide         = false;
+	bool            reconnect    = true;
+	int             pendingReads = 0;
+	int             inputBuffers = 0; // 0 keeps the system default
+	int             workers      = 0; // event loop workers with several devices, 0 for one per processor
+	std::string     statsName    = STATS_NAME;
+	FeederOptions   feeder;
+	SimulatorConfig simulator;
+
+	// One entry per [DeviceN] section, or a single device configured by [General] if there are none.
+	std::vector<DeviceConfig> devices;
+
+	// Linux only.
+	std::string output     = "uinput"; // uinput, File, Console or vGen
+	std::string outputFile = "events.bin";
+	std::string deviceName = "triolinker-vjoy";
+};
+
+/**
+ * Command line options.
+ */
+struct CommandLine
+{
+	std::string record; // capture file to write, or empty
+	std::string replay; // capture file to read instead of the device, or empty
+	bool        fast     = false; // replay as fast as possible instead of in real time
+	bool        simulate = false; // read simulated reports instead of the device
+	bool        stats    = false; // print a running feeder's counters instead of feeding
+	std::string statsName;        // name of the counters to print, or empty for StatsName in config.ini
+};
+
+FeederConfig readConfig(const IniFile& config);
+CommandLine parseCommandLine(int argc, char** argv);
+
+#endif /* CONFIG_HPP */
@@ -0,0 +1,36 @@
+/**
+ * triolinker-vjoy
+ * Decoded state output to the console.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+
+#include "ConsoleOutput.hpp"
+
+ConsoleOutput::ConsoleOutput(std::ostream& stream)
+	: m_stream(stream)
+{
+}
+
+void ConsoleOutput::commit(const JoyState& state)
+{
+	if (m_valid && std::equal(std::begin(state.axes), std::end(state.axes), std::begin(m_last.axes)) &&
+	    state.buttons == m_last.buttons && state.pov == m_last.pov)
+	{
+		return;
+	}
+
+	for (const int32_t axis : state.axes)
+	{
+		m_stream << std::dec << std::setw(6) << axis << ' ';
+	}
+
+	m_stream << std::hex << std::setfill('0') << std::setw(4) << state.buttons << std::setfill(' ')
+	         << ' ' << std::dec << std::setw(5) << state.pov << '\n';
+	called();
+
+	m_last  = state;
+	m_valid = true;
+}
@@ -0,0 +1,30 @@
+/**
+ * triolinker-vjoy
+ * Decoded state output to the console.
+ */
+
+#ifndef CONSOLEOUTPUT_HPP
+#define CONSOLEOUTPUT_HPP
+
+#include <ostream>
+
+#include "OutputSink.hpp"
+
+/**
+ * Prints each decoded state that differs from the last one, one line per state.
+ * Useful for checking a mapping without an output device.
+ */
+class ConsoleOutput : public OutputSink
+{
+public:
+	explicit ConsoleOutput(std::ostream& stream);
+
+	void commit(const JoyState& state) override;
+
+protected:
+	std::ostream& m_stream;
+	JoyState      m_last;
+	bool          m_valid = false;
+};
+
+#endif /* CONSOLEOUTPUT_HPP */
@@ -0,0 +1,342 @@
+/**
+ * triolinker-vjoy
+ * Precompiled raw report decoding.
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "DecodePlan.hpp"
+
+constexpr uint16_t USAGE_PAGE_GENERIC_DESKTOP = 0x01;
+constexpr uint16_t USAGE_PAGE_BUTTON          = 0x09;
+constexpr uint16_t USAGE_X                    = 0x30;
+constexpr uint16_t USAGE_HAT_SWITCH           = 0x39;
+
+/**
+ * Check if a button bit is actually part of the D-Pad.
+ * @param config Mapping configuration.
+ * @param buffer Raw input buffer the button is read from.
+ * @param button Button bit mask.
+ * @return True if the bit belongs to the D-Pad and must not be reported as a button.
+ */
+static bool isButtonPad(const MappingConfig& config, int buffer, uint8_t button)
+{
+	if (buffer != config.buffer_hat || config.dPadAsButtons)
+	{
+		return false;
+	}
+
+	return (config.hat_center & button) ||
+	       button == config.hat_up ||
+	       button == config.hat_up_right ||
+	       button == config.hat_right ||
+	       button == config.hat_down_right ||
+	       button == config.hat_down ||
+	       button == config.hat_down_left ||
+	       button == config.hat_left ||
+	       button == config.hat_up_left ||
+	       button == config.hat_center;
+}
+
+
+/**
+ * Build a plan that reads whole bytes at the offsets given in [Buffers].
+ * @param config Mapping configuration.
+ */
+DecodePlan::DecodePlan(const MappingConfig& config)
+	: m_config(config)
+{
+	buildDefaults();
+
+	for (size_t i = 0; i < 256; i++)
+	{
+		m_hatTable[i] = decodeHat(static_cast<uint8_t>(i));
+	}
+
+	const Transform linked = config.unlinkDpad ? Transform::UnlinkedAxis : Transform::Axis;
+
+	const int axisBuffers[AXIS_COUNT] = {
+		config.buffer_x,  config.buffer_y,  config.buffer_z,
+		config.buffer_rx, config.buffer_ry, config.buffer_rz
+	};
+
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		m_entries.push_back({ static_cast<uint16_t>(axisBuffers[i]), 0, static_cast<uint8_t>(i), i < 2 ? linked : Transform::Axis });
+	}
+
+	const int buttonBuffers[2] = { config.buffer_buttons1, config.buffer_buttons2 };
+
+	for (size_t i = 0; i < BUTTON_COUNT; i++)
+	{
+		const int     buffer = buttonBuffers[i / 8];
+		const uint8_t mask   = static_cast<uint8_t>(1 << (i % 8));
+
+		// D-Pad bits are left out entirely; the button stays released.
+		if (isButtonPad(config, buffer, mask))
+		{
+			continue;
+		}
+
+		m_entries.push_back({ static_cast<uint16_t>(buffer), mask, static_cast<uint8_t>(i), Transform::Button });
+	}
+
+	if (!config.dPadAsButtons)
+	{
+		m_entries.push_back({ static_cast<uint16_t>(config.buffer_hat), 0, 0, Transform::Hat });
+	}
+}
+
+/**
+ * Build a plan from the fields described by the device's report descriptor.
+ * Generic Desktop X, Y, Z, Rx, Ry and Rz map to the six axes, the first hat
+ * switch maps to the POV, and buttons map by usage number.
+ * [Buffers] and [DPad] are ignored.
+ * @param config Mapping configuration.
+ * @param fields Input fields of the device.
+ */
+DecodePlan::DecodePlan(const MappingConfig& config, const std::vector<HidField>& fields)
+	: m_config(config)
+{
+	buildDefaults();
+
+	std::fill(std::begin(m_hatTable), std::end(m_hatTable), -1);
+
+	bool haveReport = false;
+	bool haveHat    = false;
+
+	for (const auto& field : fields)
+	{
+		// Only fields from the first report that carries any controls are used.
+		if (haveReport && field.reportId != m_reportId)
+		{
+			continue;
+		}
+
+		if (field.usagePage == USAGE_PAGE_GENERIC_DESKTOP && field.usage == USAGE_HAT_SWITCH)
+		{
+			if (haveHat || config.dPadAsButtons || field.bitSize > 8 || field.logicalMax < field.logicalMin)
+			{
+				continue;
+			}
+
+			const int32_t count = field.logicalMax - field.logicalMin + 1;
+
+			for (int32_t i = std::max(field.logicalMin, 0); i <= field.logicalMax && i < 256; i++)
+			{
+				m_hatTable[i] = (i - field.logicalMin) * 36000 / count;
+			}
+
+			// The hat goes first so the unlinked axes can see it.
+			addField(field, 0, Transform::FieldHat);
+			std::rotate(m_entries.begin(), m_entries.end() - 1, m_entries.end());
+			haveHat = true;
+		}
+		else if (field.usagePage == USAGE_PAGE_GENERIC_DESKTOP && field.usage >= USAGE_X && field.usage < USAGE_X + AXIS_COUNT)
+		{
+			const auto axis = static_cast<uint8_t>(field.usage - USAGE_X);
+			addField(field, axis, config.unlinkDpad && axis < 2 ? Transform::UnlinkedFieldAxis : Transform::FieldAxis);
+		}
+		else if (field.usagePage == USAGE_PAGE_BUTTON && field.usage >= 1 && field.usage <= BUTTON_COUNT && field.bitSize == 1)
+		{
+			m_entries.push_back({ static_cast<uint16_t>(field.bitOffset / 8), static_cast<uint8_t>(1 << (field.bitOffset % 8)),
+			                      static_cast<uint8_t>(field.usage - 1), Transform::Button });
+		}
+		else
+		{
+			continue;
+		}
+
+		m_reportId = field.reportId;
+		haveReport = true;
+	}
+}
+
+/**
+ * Decode a raw report.
+ * @param report Raw input report.
+ * @param state Output state. Overwritten entirely, unless the report has a
+ * report ID the plan doesn't use, in which case it is left untouched.
+ */
+void DecodePlan::decode(const uint8_t* report, JoyState& state) const
+{
+	if (m_reportId != 0 && report[0] != m_reportId)
+	{
+		return;
+	}
+
+	state = JoyState {};
+
+	for (const auto& entry : m_entries)
+	{
+		const uint8_t value = report[entry.offset];
+
+		switch (entry.transform)
+		{
+			case Transform::UnlinkedAxis:
+				if (report[m_config.buffer_hat] != m_config.hat_center)
+				{
+					state.axes[entry.control] = m_axisDefaults[entry.control];
+					break;
+				}
+				// fall through
+			case Transform::Axis:
+				state.axes[entry.control] = m_axisTables[entry.control][value];
+				break;
+
+			case Transform::Button:
+				if (value & entry.mask)
+				{
+					state.buttons |= 1u << entry.control;
+				}
+				break;
+
+			case Transform::Hat:
+				state.pov = m_hatTable[value];
+				break;
+
+			case Transform::UnlinkedFieldAxis:
+				if (state.pov != -1)
+				{
+					state.axes[entry.control] = m_axisDefaults[entry.control];
+					break;
+				}
+				// fall through
+			case Transform::FieldAxis:
+			{
+				const int64_t field = std::clamp(decodeField(report, entry), entry.min, entry.max) - entry.min;
+				state.axes[entry.control] = m_config.axisRanges[entry.control].min + static_cast<int32_t>((field * entry.scale + 0x8000) >> 16);
+				break;
+			}
+
+			case Transform::FieldHat:
+				state.pov = m_hatTable[decodeField(report, entry) & 0xFF];
+				break;
+		}
+	}
+}
+
+/**
+ * @return Length of the shortest report the plan can decode, as decode()
+ * reads every byte up to the end of the last field it uses.
+ */
+size_t DecodePlan::reportLength() const
+{
+	size_t length = 0;
+
+	for (const auto& entry : m_entries)
+	{
+		length = std::max<size_t>(length, entry.offset + entry.bytes);
+
+		// The unlinked axes also look at the hat.
+		if (entry.transform == Transform::UnlinkedAxis)
+		{
+			length = std::max<size_t>(length, static_cast<uint16_t>(m_config.buffer_hat) + 1);
+		}
+	}
+
+	return length;
+}
+
+const std::vector<DecodeEntry>& DecodePlan::entries() const
+{
+	return m_entries;
+}
+
+/**
+ * Build the axis tables and default positions shared by both layouts.
+ */
+void DecodePlan::buildDefaults()
+{
+	for (size_t axis = 0; axis < AXIS_COUNT; axis++)
+	{
+		const int64_t min   = m_config.axisRanges[axis].min;
+		const int64_t range = m_config.axisRanges[axis].max - min;
+
+		for (int64_t i = 0; i < 256; i++)
+		{
+			m_axisTables[axis][i] = static_cast<int32_t>(min + (i * range + 127) / 255);
+		}
+	}
+
+	const float defaults[2] = { m_config.defaultX, m_config.defaultY };
+
+	for (size_t axis = 0; axis < 2; axis++)
+	{
+		const AxisRange& range = m_config.axisRanges[axis];
+		m_axisDefaults[axis] = range.min + static_cast<int32_t>(defaults[axis] / 100.0f * static_cast<float>(range.max - range.min) + 0.5f);
+	}
+}
+
+/**
+ * Append a bit field entry with its extraction parameters precomputed.
+ * @param field Field to read.
+ * @param control Output control index.
+ * @param transform Field transform.
+ */
+void DecodePlan::addField(const HidField& field, uint8_t control, Transform transform)
+{
+	DecodeEntry entry { static_cast<uint16_t>(field.bitOffset / 8), 0, control, transform };
+
+	entry.shift     = static_cast<uint8_t>(field.bitOffset % 8);
+	entry.bytes     = static_cast<uint8_t>((entry.shift + field.bitSize + 7) / 8);
+	entry.sign      = field.logicalMin < 0;
+	entry.fieldMask = static_cast<uint32_t>((static_cast<uint64_t>(1) << field.bitSize) - 1);
+	entry.min       = field.logicalMin;
+	entry.max       = std::max(field.logicalMax, field.logicalMin + 1);
+
+	if (transform != Transform::FieldHat)
+	{
+		const AxisRange& range = m_config.axisRanges[control];
+		entry.scale = (static_cast<int64_t>(range.max - range.min) << 16) / (static_cast<int64_t>(entry.max) - entry.min);
+	}
+
+	m_entries.push_back(entry);
+}
+
+/**
+ * Convert a raw D-Pad value to a POV angle.
+ * Only used to build the hat table.
+ * @param value Raw D-Pad value.
+ * @return Angle in 1/100 degrees, or -1 if centered or unrecognized.
+ */
+int32_t DecodePlan::decodeHat(uint8_t value) const
+{
+	if (value == m_config.hat_center) return -1;
+	if (value == m_config.hat_up) return 0;
+	if (value == m_config.hat_up_right) return 4500;
+	if (value == m_config.hat_right) return 9000;
+	if (value == m_config.hat_down_right) return 13500;
+	if (value == m_config.hat_down) return 18000;
+	if (value == m_config.hat_down_left) return 22500;
+	if (value == m_config.hat_left) return 27000;
+	if (value == m_config.hat_up_left) return 31500;
+	return -1;
+}
+
+/**
+ * Extract a bit field from a report.
+ * @param report Raw input report.
+ * @param entry Field entry.
+ * @return Field value, sign-extended if the field's logical range is signed.
+ */
+int32_t DecodePlan::decodeField(const uint8_t* report, const DecodeEntry& entry) const
+{
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < entry.bytes; i++)
+	{
+		value |= static_cast<uint64_t>(report[entry.offset + i]) << (i * 8);
+	}
+
+	const auto field = static_cast<uint32_t>(value >> entry.shift) & entry.fieldMask;
+
+	if (entry.sign)
+	{
+		const uint32_t signBit = (entry.fieldMask >> 1) + 1;
+		return static_cast<int32_t>((field ^ signBit) - signBit);
+	}
+
+	return static_cast<int32_t>(field);
+}
@@ -0,0 +1,144 @@
+/**
+ * triolinker-vjoy
+ * Precompiled raw report decoding.
+ */
+
+#ifndef DECODEPLAN_HPP
+#define DECODEPLAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr size_t AXIS_COUNT   = 6;
+constexpr size_t BUTTON_COUNT = 16;
+
+/**
+ * Logical range of an output axis.
+ */
+struct AxisRange
+{
+	int32_t min = 0;
+	int32_t max = 0x8000;
+};
+
+/**
+ * Raw report layout, as read from config.ini.
+ */
+struct MappingConfig
+{
+	bool  unlinkDpad    = true;
+	bool  dPadAsButtons = false;
+	float defaultX      = 50.1f;
+	float defaultY      = 50.1f;
+
+	int buffer_x        = 3;
+	int buffer_y        = 4;
+	int buffer_z        = 0;
+	int buffer_rx       = 0;
+	int buffer_ry       = 0;
+	int buffer_rz       = 0;
+	int buffer_buttons1 = 1;
+	int buffer_buttons2 = 2;
+	int buffer_hat      = 2;
+
+	uint8_t hat_up         = 0x10;
+	uint8_t hat_up_right   = 0x30;
+	uint8_t hat_up_left    = 0x90;
+	uint8_t hat_down       = 0x40;
+	uint8_t hat_down_right = 0x60;
+	uint8_t hat_down_left  = 0xC0;
+	uint8_t hat_left       = 0x80;
+	uint8_t hat_right      = 0x20;
+	uint8_t hat_center     = 0;
+
+	// Filled in from the output device rather than config.ini.
+	AxisRange axisRanges[AXIS_COUNT];
+};
+
+/**
+ * A single input field located in a HID report.
+ */
+struct HidField
+{
+	uint16_t usagePage  = 0;
+	uint16_t usage      = 0;
+	uint8_t  reportId   = 0;
+	uint16_t bitOffset  = 0; // from the start of the report, including the report ID byte
+	uint8_t  bitSize    = 0;
+	int32_t  logicalMin = 0;
+	int32_t  logicalMax = 0;
+};
+
+/**
+ * Decoded controller state for a single report.
+ */
+struct JoyState
+{
+	int32_t  axes[AXIS_COUNT] {}; // logical values within MappingConfig::axisRanges
+	uint32_t buttons = 0;         // bit n = vJoy button n + 1
+	int32_t  pov     = -1;        // 1/100 degrees, or -1 for centered
+};
+
+enum class Transform : uint8_t
+{
+	Axis,              // byte looked up in the axis table
+	UnlinkedAxis,      // as Axis, but forced to its default while the D-Pad is held
+	Button,            // set button bit if (byte & mask) != 0
+	Hat,               // byte looked up in the hat table
+	FieldAxis,         // bit field scaled from its logical range to the axis range
+	UnlinkedFieldAxis, // as FieldAxis, but forced to its default while the POV is held
+	FieldHat,          // bit field looked up in the hat table
+};
+
+struct DecodeEntry
+{
+	uint16_t  offset;  // byte offset into the raw report
+	uint8_t   mask;    // bit mask for Transform::Button
+	uint8_t   control; // axis, button or POV index (0-based)
+	Transform transform;
+
+	// Bit fields only.
+	uint8_t  shift     = 0; // bit offset within the first byte
+	uint8_t  bytes     = 1; // number of bytes the field spans
+	bool     sign      = false;
+	uint32_t fieldMask = 0;
+	int32_t  min       = 0; // logical range of the field
+	int32_t  max       = 0;
+	int64_t  scale     = 0; // 16.16 fixed point, field range to axis range
+};
+
+/**
+ * Flat list of decode steps compiled once from a MappingConfig, so the
+ * read loop doesn't need to re-evaluate the configuration on every report.
+ */
+class DecodePlan
+{
+public:
+	explicit DecodePlan(const MappingConfig& config);
+	DecodePlan(const MappingConfig& config, const std::vector<HidField>& fields);
+
+	void decode(const uint8_t* report, JoyState& state) const;
+	size_t reportLength() const;
+
+	const std::vector<DecodeEntry>& entries() const;
+
+protected:
+	void buildDefaults();
+	void addField(const HidField& field, uint8_t control, Transform transform);
+
+	int32_t decodeHat(uint8_t value) const;
+	int32_t decodeField(const uint8_t* report, const DecodeEntry& entry) const;
+
+	std::vector<DecodeEntry> m_entries;
+
+	MappingConfig m_config;
+	uint8_t       m_reportId = 0; // reports with any other ID are ignored; 0 if the device doesn't use IDs
+	int32_t       m_axisDefaults[AXIS_COUNT] {};
+
+	// Byte inputs and hat fields are at most 8 bits wide, so their mappings are fully precomputed.
+	int32_t m_axisTables[AXIS_COUNT][256] {};
+	int32_t m_hatTable[256] {};
+};
+
+#endif /* DECODEPLAN_HPP */
@@ -0,0 +1,196 @@
+/**
+ * triolinker-vjoy
+ * Notification of HID devices being plugged in.
+ */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <cfgmgr32.h>
+#include <hidsdi.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "DeviceWatcher.hpp"
+
+#ifdef _WIN32
+static DWORD CALLBACK notify(HCMNOTIFICATION, PVOID context, CM_NOTIFY_ACTION action, PCM_NOTIFY_EVENT_DATA data, DWORD)
+{
+	if (action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL)
+	{
+		(*static_cast<DeviceWatcher::Callback*>(context))(data->u.DeviceInterface.SymbolicLink);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void CALLBACK rescanWork(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WORK)
+{
+	(*static_cast<DeviceWatcher::Callback*>(context))(std::filesystem::path());
+}
+#endif
+
+/**
+ * Start watching. Check valid() before relying on notifications.
+ * @param arrived Called with the path of each device that appears, or an empty path after rescan().
+ */
+DeviceWatcher::DeviceWatcher(Callback arrived)
+	: m_arrived(std::move(arrived))
+{
+#ifdef _WIN32
+	CM_NOTIFY_FILTER filter {};
+	filter.cbSize     = sizeof(filter);
+	filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+	HidD_GetHidGuid(&filter.u.DeviceInterface.ClassGuid);
+
+	HCMNOTIFICATION notification = nullptr;
+
+	m_rescan = CreateThreadpoolWork(rescanWork, &m_arrived, nullptr);
+
+	if (m_rescan != nullptr && CM_Register_Notification(&filter, &m_arrived, notify, &notification) == CR_SUCCESS)
+	{
+		m_notification = notification;
+	}
+#else
+	m_inotify = inotify_init1(IN_CLOEXEC);
+	m_stop    = eventfd(0, EFD_CLOEXEC);
+	m_rescan  = eventfd(0, EFD_CLOEXEC);
+
+	if (m_inotify < 0 || m_stop < 0 || m_rescan < 0 || inotify_add_watch(m_inotify, "/dev", IN_CREATE | IN_ATTRIB) < 0)
+	{
+		return;
+	}
+
+	m_thread = std::thread([this] { run(); });
+#endif
+}
+
+DeviceWatcher::~DeviceWatcher()
+{
+#ifdef _WIN32
+	if (m_notification != nullptr)
+	{
+		// Waits for a callback in progress to return.
+		CM_Unregister_Notification(static_cast<HCMNOTIFICATION>(m_notification));
+	}
+
+	if (m_rescan != nullptr)
+	{
+		WaitForThreadpoolWorkCallbacks(static_cast<PTP_WORK>(m_rescan), FALSE);
+		CloseThreadpoolWork(static_cast<PTP_WORK>(m_rescan));
+	}
+#else
+	if (m_thread.joinable())
+	{
+		const uint64_t value = 1;
+		write(m_stop, &value, sizeof(value));
+		m_thread.join();
+	}
+
+	for (const int fd : { m_inotify, m_stop, m_rescan })
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+#endif
+}
+
+/**
+ * @return True if device arrivals are being watched.
+ */
+bool DeviceWatcher::valid() const
+{
+#ifdef _WIN32
+	return m_notification != nullptr;
+#else
+	return m_thread.joinable();
+#endif
+}
+
+/**
+ * Call the callback with an empty path on the watcher's thread, so whoever
+ * asks isn't held up while every device is looked through. Requests made
+ * before an earlier one is handled may be merged.
+ */
+void DeviceWatcher::rescan()
+{
+#ifdef _WIN32
+	if (m_rescan != nullptr)
+	{
+		SubmitThreadpoolWork(static_cast<PTP_WORK>(m_rescan));
+	}
+#else
+	if (m_thread.joinable())
+	{
+		const uint64_t value = 1;
+		write(m_rescan, &value, sizeof(value));
+	}
+#endif
+}
+
+#ifndef _WIN32
+void DeviceWatcher::run()
+{
+	pollfd fds[3] {};
+	fds[0].fd     = m_inotify;
+	fds[0].events = POLLIN;
+	fds[1].fd     = m_stop;
+	fds[1].events = POLLIN;
+	fds[2].fd     = m_rescan;
+	fds[2].events = POLLIN;
+
+	alignas(inotify_event) char buffer[4096];
+
+	for (;;)
+	{
+		if (poll(fds, 3, -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return;
+		}
+
+		if (fds[1].revents != 0)
+		{
+			return;
+		}
+
+		if (fds[2].revents != 0)
+		{
+			uint64_t value;
+			read(m_rescan, &value, sizeof(value));
+			m_arrived(std::filesystem::path());
+		}
+
+		if (fds[0].revents == 0)
+		{
+			continue;
+		}
+
+		const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+			if (event->len != 0 && std::strncmp(event->name, "hidraw", 6) == 0)
+			{
+				m_arrived(std::filesystem::path("/dev") / event->name);
+			}
+
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+		}
+	}
+}
+#endif
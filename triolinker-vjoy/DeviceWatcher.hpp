@@ -0,0 +1,59 @@
+/**
+ * triolinker-vjoy
+ * Notification of HID devices being plugged in.
+ */
+
+#ifndef DEVICEWATCHER_HPP
+#define DEVICEWATCHER_HPP
+
+#include <filesystem>
+#include <functional>
+
+#ifndef _WIN32
+#include <thread>
+#endif
+
+/**
+ * Reports the path of every HID device that appears while it exists, so a
+ * disconnected device can be reopened as soon as it is back, without
+ * enumerating every device again.
+ * On Windows this is a configuration manager notification for HID device
+ * interfaces; on Linux an inotify watch on /dev for hidraw nodes. A node is
+ * reported again when udev changes its permissions, since it may not be
+ * accessible before then.
+ * rescan() asks for the callback to be called with an empty path, meaning
+ * every device should be looked through.
+ * The callback runs on a thread of its own; on Windows, arrivals and
+ * rescans may be reported on two threads at once.
+ */
+class DeviceWatcher
+{
+public:
+	using Callback = std::function<void(const std::filesystem::path& path)>;
+
+	explicit DeviceWatcher(Callback arrived);
+	~DeviceWatcher();
+
+	DeviceWatcher(const DeviceWatcher&) = delete;
+	DeviceWatcher& operator=(const DeviceWatcher&) = delete;
+
+	bool valid() const;
+	void rescan();
+
+protected:
+	Callback m_arrived;
+
+#ifdef _WIN32
+	void* m_notification = nullptr; // HCMNOTIFICATION
+	void* m_rescan       = nullptr; // PTP_WORK
+#else
+	void run();
+
+	int         m_inotify = -1;
+	int         m_stop    = -1; // eventfd ending the thread
+	int         m_rescan  = -1; // eventfd asking for a rescan
+	std::thread m_thread;
+#endif
+};
+
+#endif /* DEVICEWATCHER_HPP */
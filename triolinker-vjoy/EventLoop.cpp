@@ -0,0 +1,318 @@
+/**
+ * triolinker-vjoy
+ * Event loop feeding several devices from a pool of worker threads.
+ */
+
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include "EventLoop.hpp"
+
+// Completion key (Windows) or epoll data (Linux) telling the workers to stop.
+constexpr uint64_t STOP_KEY = UINT64_MAX;
+
+/**
+ * @param workers Number of worker threads, or 0 for one per processor.
+ * There are never more workers than sources.
+ */
+EventLoop::EventLoop(size_t workers)
+	: m_workers(workers != 0 ? workers : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+{
+}
+
+/**
+ * @param source Source the feeder reads from.
+ * @param feeder Single-threaded feeder reading from source. With more than one worker,
+ * feeders sharing a stats block must have been told so through Feeder::publish().
+ */
+void EventLoop::add(ReportSource& source, Feeder& feeder)
+{
+	auto& entry  = *m_entries.emplace_back(std::make_unique<Entry>());
+	entry.source = &source;
+	entry.feeder = &feeder;
+}
+
+/**
+ * Keep feeders whose source ended instead of dropping them. Must be called before run().
+ * @param callback Called from a worker with the index of the ended entry, in the order
+ * entries were added. The feeder is no longer stepped and may be used until reattach().
+ */
+void EventLoop::onEnded(EndedCallback callback)
+{
+	m_ended = std::move(callback);
+}
+
+/**
+ * Resume an entry whose source ended, with a new source for its feeder.
+ * Only while running, and only after the ended callback was called for it.
+ * @param index Entry index.
+ * @param source New source, already attached to the feeder. Its reads are reposted on Windows.
+ */
+void EventLoop::reattach(size_t index, ReportSource& source)
+{
+	Entry& entry = *m_entries[index];
+	entry.source = &source;
+
+#ifdef _WIN32
+	const HANDLE port = reinterpret_cast<HANDLE>(m_port);
+
+	CreateIoCompletionPort(source.waitHandle(), port, index, 0);
+	source.flush();
+	entry.done.store(false, std::memory_order_release);
+
+	// Reads that completed before the entry was live were ignored; have a worker look.
+	PostQueuedCompletionStatus(port, 0, index, nullptr);
+#else
+	entry.done.store(false, std::memory_order_release);
+
+	epoll_event event {};
+	event.events   = EPOLLIN | EPOLLONESHOT;
+	event.data.u64 = index;
+
+	epoll_ctl(static_cast<int>(m_port), EPOLL_CTL_ADD, source.waitHandle(), &event);
+#endif
+}
+
+/**
+ * @return Number of worker threads run() uses.
+ */
+size_t EventLoop::workers() const
+{
+	return std::clamp<size_t>(m_entries.size(), 1, m_workers);
+}
+
+/**
+ * Run until every source has failed or ended.
+ * The calling thread is one of the workers.
+ */
+void EventLoop::run()
+{
+	m_remaining = m_entries.size();
+
+	if (m_entries.empty())
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	const HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, static_cast<DWORD>(workers()));
+
+	if (port == nullptr)
+	{
+		return;
+	}
+
+	m_port = reinterpret_cast<intptr_t>(port);
+
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		Entry& entry = *m_entries[i];
+		CreateIoCompletionPort(entry.source->waitHandle(), port, i, 0);
+
+		// Reads posted before the handle joined the port never complete to it, so post them again.
+		entry.source->flush();
+	}
+#else
+	m_port = epoll_create1(EPOLL_CLOEXEC);
+	m_stop = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+	if (m_port < 0 || m_stop < 0)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		// One-shot, so a device wakes a single worker until that worker rearms it.
+		epoll_event event {};
+		event.events   = EPOLLIN | EPOLLONESHOT;
+		event.data.u64 = i;
+
+		epoll_ctl(static_cast<int>(m_port), EPOLL_CTL_ADD, m_entries[i]->source->waitHandle(), &event);
+	}
+
+	// Level-triggered and never read, so once written it wakes every worker.
+	epoll_event event {};
+	event.events   = EPOLLIN;
+	event.data.u64 = STOP_KEY;
+
+	epoll_ctl(static_cast<int>(m_port), EPOLL_CTL_ADD, m_stop, &event);
+#endif
+
+	std::vector<std::thread> threads;
+
+	for (size_t i = 1; i < workers(); i++)
+	{
+		threads.emplace_back([this] { work(); });
+	}
+
+	work();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+#ifdef _WIN32
+	CloseHandle(port);
+#else
+	close(m_stop);
+	close(static_cast<int>(m_port));
+#endif
+}
+
+/**
+ * Worker thread: step devices as their reports arrive until every source has ended.
+ */
+void EventLoop::work()
+{
+#ifdef _WIN32
+	const HANDLE port = reinterpret_cast<HANDLE>(m_port);
+
+	for (;;)
+	{
+		DWORD       bytes;
+		ULONG_PTR   key;
+		OVERLAPPED* overlapped;
+
+		// Failed reads are dequeued as failures too; reading them ends their feeder.
+		if (!GetQueuedCompletionStatus(port, &bytes, &key, &overlapped, INFINITE) && overlapped == nullptr)
+		{
+			return;
+		}
+
+		if (key == STOP_KEY)
+		{
+			return;
+		}
+
+		Entry& entry = *m_entries[key];
+
+		// A device is served by whichever worker got its first outstanding completion.
+		// Completions arriving meanwhile only make that worker check again.
+		if (entry.pending.fetch_add(1, std::memory_order_acq_rel) != 0)
+		{
+			continue;
+		}
+
+		do
+		{
+			// A finished entry's feeder may be reattached by the watcher meanwhile, so leave it alone.
+			if (!entry.done.load(std::memory_order_acquire))
+			{
+				entry.feeder->wake();
+
+				if (!serve(entry))
+				{
+					finish(key);
+				}
+			}
+		}
+		while (entry.pending.fetch_sub(1, std::memory_order_acq_rel) != 1);
+	}
+#else
+	const int epoll = static_cast<int>(m_port);
+
+	for (;;)
+	{
+		epoll_event event {};
+		const int   count = epoll_wait(epoll, &event, 1, -1);
+
+		if (count < 0 && errno != EINTR)
+		{
+			return;
+		}
+
+		if (count <= 0)
+		{
+			continue;
+		}
+
+		if (event.data.u64 == STOP_KEY)
+		{
+			return;
+		}
+
+		const size_t index = event.data.u64;
+		Entry&       entry = *m_entries[index];
+
+		// The one-shot registration already keeps other workers away until the entry is rearmed.
+		// The lock, never contended for longer than the rearm itself, orders the hand-off in the memory model too.
+		std::unique_lock<std::mutex> lock(entry.mutex);
+
+		entry.feeder->wake();
+
+		// Hangups get a step too, so the failing read ends the feeder.
+		if (entry.feeder->step() && serve(entry))
+		{
+			event.events = EPOLLIN | EPOLLONESHOT;
+			epoll_ctl(epoll, EPOLL_CTL_MOD, entry.source->waitHandle(), &event);
+		}
+		else
+		{
+			epoll_ctl(epoll, EPOLL_CTL_DEL, entry.source->waitHandle(), nullptr);
+			lock.unlock();
+			finish(index);
+		}
+	}
+#endif
+}
+
+/**
+ * Step a feeder until its source has no more reports ready.
+ * @param entry Entry to serve; only ever served by one worker at a time.
+ * @return False once the source has failed or ended.
+ */
+bool EventLoop::serve(Entry& entry)
+{
+	while (entry.source->ready())
+	{
+		if (!entry.feeder->step())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Drop an entry whose source has ended, stopping every worker if it was the last one.
+ * With an ended callback, hand it to the callback instead.
+ * @param index Entry index.
+ */
+void EventLoop::finish(size_t index)
+{
+	m_entries[index]->done.store(true, std::memory_order_release);
+
+	if (m_ended)
+	{
+		m_ended(index);
+		return;
+	}
+
+	if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	for (size_t i = 0; i < workers(); i++)
+	{
+		PostQueuedCompletionStatus(reinterpret_cast<HANDLE>(m_port), 0, STOP_KEY, nullptr);
+	}
+#else
+	const uint64_t value = 1;
+	write(m_stop, &value, sizeof(value));
+#endif
+}
@@ -0,0 +1,65 @@
+/**
+ * triolinker-vjoy
+ * Event loop feeding several devices from a pool of worker threads.
+ */
+
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Feeder.hpp"
+#include "ReportSource.hpp"
+
+/**
+ * Waits on the sources of several single-threaded feeders at once and steps
+ * whichever have a report ready, so any number of devices are fed from a few
+ * worker threads. On Windows every source's reads complete to one I/O
+ * completion port; on Linux every source is registered with one epoll
+ * instance. Either way a device is only ever stepped by one worker at a time.
+ * Every source must have a wait handle. A feeder whose source fails or ends
+ * is dropped; the others carry on. With an ended callback set, such a feeder
+ * is kept instead, so it can be reattached to its reopened device, and the
+ * loop runs until the process ends.
+ */
+class EventLoop
+{
+public:
+	explicit EventLoop(size_t workers = 0);
+
+	using EndedCallback = std::function<void(size_t index)>;
+
+	void add(ReportSource& source, Feeder& feeder);
+	void onEnded(EndedCallback callback);
+	void reattach(size_t index, ReportSource& source);
+	size_t workers() const;
+	void run();
+
+protected:
+	struct Entry
+	{
+		ReportSource*       source;            // only replaced while done
+		Feeder*             feeder;
+		std::atomic<size_t> pending { 0 };     // Windows: completions not yet handled by the worker serving this entry
+		std::atomic<bool>   done    { false };
+		std::mutex          mutex;             // Linux: held by the worker serving this entry until it is rearmed
+	};
+
+	void work();
+	bool serve(Entry& entry);
+	void finish(size_t index);
+
+	size_t                              m_workers;
+	std::vector<std::unique_ptr<Entry>> m_entries;
+	std::atomic<size_t>                 m_remaining { 0 };
+	EndedCallback                       m_ended;
+	intptr_t                            m_port = 0;  // completion port HANDLE (Windows) or epoll descriptor (Linux)
+	int                                 m_stop = -1; // Linux: eventfd waking every worker once all sources have ended
+};
+
+#endif /* EVENTLOOP_HPP */
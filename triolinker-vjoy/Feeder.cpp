@@ -0,0 +1,287 @@
+/**
+ * triolinker-vjoy
+ * Report-to-output pipeline.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Feeder.hpp"
+#include "ReportQueue.hpp"
+
+/**
+ * @return Monotonic time in nanoseconds.
+ */
+static uint64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Feeder::Feeder(const DecodePlan& plan, ReportSource& source, OutputSink& sink, const FeederOptions& options)
+	: m_plan(plan),
+	  m_source(&source),
+	  m_sink(sink),
+	  m_options(options),
+	  m_buffer(source.reportLength())
+{
+	m_sink.countCalls(&m_stats->outputCalls, false);
+}
+
+/**
+ * Run the pipeline. Returns once the source fails or ends.
+ */
+void Feeder::run()
+{
+	if (m_options.threaded)
+	{
+		runThreaded();
+	}
+	else
+	{
+		runSingle();
+	}
+}
+
+/**
+ * Continue with a new source, such as the device reopened after it was reconnected.
+ * Counters and latency carry on. Not while running.
+ * @param source New source.
+ */
+void Feeder::attach(ReportSource& source)
+{
+	m_source   = &source;
+	m_lastRead = 0;
+	m_buffer.resize(source.reportLength());
+}
+
+/**
+ * Bring the output to rest, e.g. after the device was disconnected,
+ * so no button stays held and no axis stays deflected. Not while running.
+ */
+void Feeder::reset()
+{
+	m_state = JoyState();
+	m_coalescer.reset();
+	m_sink.reset();
+}
+
+/**
+ * @return Total number of reports dropped by coalescing.
+ */
+uint64_t Feeder::coalesced() const
+{
+	return m_coalescer.coalesced();
+}
+
+/**
+ * @return Number of times a backlog of stale reports was discarded.
+ */
+uint64_t Feeder::flushes() const
+{
+	return m_flushes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return Read-to-commit latency of every committed state.
+ */
+const LatencyHistogram& Feeder::latency() const
+{
+	return m_latency;
+}
+
+/**
+ * Count into a shared stats block instead of a private one.
+ * Must be called before run().
+ * @param stats Stats block, or nullptr to keep counting privately.
+ * @param concurrent True if other feeders count into the same block from other threads.
+ */
+void Feeder::publish(StatsBlock* stats, bool concurrent)
+{
+	m_stats           = stats != nullptr ? stats : &m_localStats;
+	m_concurrentStats = stats != nullptr && concurrent;
+
+	// The sink counts its own driver calls, which may be any number per state.
+	m_sink.countCalls(&m_stats->outputCalls, m_concurrentStats);
+}
+
+/**
+ * Read one report, or with coalescing every report that is already waiting,
+ * and commit the result. Blocks until a report is available.
+ * Only for single-threaded feeders.
+ * @return False once the source fails or ends.
+ */
+bool Feeder::step()
+{
+	uint64_t readTime;
+
+	if (!read(m_buffer.data(), readTime))
+	{
+		count(m_stats->readErrors);
+		return false;
+	}
+
+	count(m_stats->reportsRead);
+	count(m_stats->reportsMapped);
+	m_plan.decode(m_buffer.data(), m_state);
+
+	while (m_options.coalesce && m_source->ready() && m_source->read(m_buffer.data()))
+	{
+		count(m_stats->reportsRead);
+		count(m_stats->reportsMapped);
+		count(m_stats->reportsCoalesced);
+		m_coalescer.skip(m_state);
+		m_plan.decode(m_buffer.data(), m_state);
+	}
+
+	commit(m_state, readTime);
+	return true;
+}
+
+/**
+ * Start timing stalls afresh, as a stepped source just became ready.
+ * The time spent waiting for input before that is no stall.
+ * Only for single-threaded feeders.
+ */
+void Feeder::wake()
+{
+	if (m_options.staleAfter != 0)
+	{
+		m_lastRead = now();
+	}
+}
+
+void Feeder::runSingle()
+{
+	while (step())
+	{
+	}
+}
+
+void Feeder::runThreaded()
+{
+	ReportQueue queue(m_options.queueLength, m_source->reportLength());
+
+	std::thread readerThread([&]
+	{
+		configureThread(m_options.reader);
+
+		std::vector<uint8_t> buffer(m_source->reportLength());
+		uint64_t readTime;
+
+		while (read(buffer.data(), readTime))
+		{
+			count(m_stats->reportsRead);
+			queue.push(buffer.data(), readTime);
+
+			const size_t depth = queue.size();
+			m_stats->queueDepth.store(depth, std::memory_order_relaxed);
+
+			if (depth > m_stats->queuePeak.load(std::memory_order_relaxed))
+			{
+				m_stats->queuePeak.store(depth, std::memory_order_relaxed);
+			}
+		}
+
+		count(m_stats->readErrors);
+		queue.close();
+	});
+
+	std::thread outputThread([&]
+	{
+		configureThread(m_options.output);
+
+		JoyState state;
+
+		while (const uint8_t* report = queue.wait())
+		{
+			// Skip straight to the newest of the stale reports; its state is still the latest known.
+			if (m_options.staleAfter != 0 && queue.size() > 1 && now() - queue.timestamp() > m_options.staleAfter)
+			{
+				m_flushes.fetch_add(1, std::memory_order_relaxed);
+
+				do
+				{
+					queue.pop();
+				}
+				while (queue.size() > 1 && now() - queue.timestamp() > m_options.staleAfter);
+
+				report = queue.wait();
+			}
+
+			const uint64_t readTime = queue.timestamp();
+
+			count(m_stats->reportsMapped);
+			m_plan.decode(report, state);
+			queue.pop();
+
+			while (m_options.coalesce && queue.size() > 0)
+			{
+				count(m_stats->reportsMapped);
+				count(m_stats->reportsCoalesced);
+				m_coalescer.skip(state);
+				m_plan.decode(queue.wait(), state);
+				queue.pop();
+			}
+
+			commit(state, readTime);
+		}
+	});
+
+	readerThread.join();
+	outputThread.join();
+}
+
+/**
+ * Read the next report, first flushing the source if this loop was held up for too long.
+ * The reports that arrived in the meantime describe input that is no longer current.
+ * @param report Destination buffer.
+ * @param readTime Set to the time the read completed, if latency or stale reports are tracked.
+ * @return False once the source fails or ends.
+ */
+bool Feeder::read(uint8_t* report, uint64_t& readTime)
+{
+	if (m_options.staleAfter != 0 && m_lastRead != 0 && now() - m_lastRead > m_options.staleAfter)
+	{
+		m_flushes.fetch_add(1, std::memory_order_relaxed);
+		m_source->flush();
+	}
+
+	if (!m_source->read(report))
+	{
+		return false;
+	}
+
+	readTime   = m_options.latency || m_options.staleAfter != 0 ? now() : 0;
+	m_lastRead = readTime;
+	return true;
+}
+
+void Feeder::count(std::atomic<uint64_t>& counter)
+{
+	if (m_concurrentStats)
+	{
+		add(counter);
+	}
+	else
+	{
+		bump(counter);
+	}
+}
+
+void Feeder::commit(const JoyState& state, uint64_t readTime)
+{
+	JoyState pulse;
+
+	if (m_coalescer.flush(state, pulse))
+	{
+		m_sink.commit(pulse);
+	}
+
+	m_sink.commit(state);
+
+	if (m_options.latency)
+	{
+		m_latency.record(now() - readTime);
+	}
+}
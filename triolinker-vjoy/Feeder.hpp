@@ -0,0 +1,84 @@
+/**
+ * triolinker-vjoy
+ * Report-to-output pipeline.
+ */
+
+#ifndef FEEDER_HPP
+#define FEEDER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Coalescer.hpp"
+#include "DecodePlan.hpp"
+#include "LatencyHistogram.hpp"
+#include "OutputSink.hpp"
+#include "ReportSource.hpp"
+#include "Stats.hpp"
+#include "Thread.hpp"
+
+struct FeederOptions
+{
+	bool          coalesce    = false;
+	bool          threaded    = false;
+	int           queueLength = 64;
+	bool          latency     = false;
+	uint64_t      staleAfter  = 0; // nanoseconds; backlogs older than this are flushed, 0 to keep them
+	ThreadOptions reader;
+	ThreadOptions output;
+};
+
+/**
+ * Reads reports from a source, decodes them and commits them to a sink
+ * until the source fails.
+ * With latency enabled, the time from a report's read completing to its
+ * commit returning is recorded. For coalesced reports the oldest read counts.
+ * With staleAfter set, a stall of the read loop longer than that flushes the
+ * reports that piled up in the source meanwhile, and in threaded mode queued
+ * reports older than that are skipped.
+ * Several single-threaded feeders can share a thread by calling wake() and
+ * step() whenever their source is ready, instead of run().
+ * When the source ends because the device went away, reset() brings the
+ * output to rest and attach() continues with the reopened device.
+ */
+class Feeder
+{
+public:
+	Feeder(const DecodePlan& plan, ReportSource& source, OutputSink& sink, const FeederOptions& options);
+
+	void run();
+	bool step();
+	void wake();
+	void attach(ReportSource& source);
+	void reset();
+
+	uint64_t coalesced() const;
+	uint64_t flushes() const;
+	const LatencyHistogram& latency() const;
+
+	void publish(StatsBlock* stats, bool concurrent = false);
+
+protected:
+	void runSingle();
+	void runThreaded();
+	bool read(uint8_t* report, uint64_t& readTime);
+	void commit(const JoyState& state, uint64_t readTime);
+	void count(std::atomic<uint64_t>& counter);
+
+	const DecodePlan&     m_plan;
+	ReportSource*         m_source;
+	OutputSink&           m_sink;
+	FeederOptions         m_options;
+	Coalescer             m_coalescer;
+	LatencyHistogram      m_latency;
+	StatsBlock            m_localStats;
+	StatsBlock*           m_stats           = &m_localStats;
+	bool                  m_concurrentStats = false;
+	uint64_t              m_lastRead        = 0;
+	std::atomic<uint64_t> m_flushes { 0 }; // bumped by both threads in threaded mode
+	std::vector<uint8_t>  m_buffer;
+	JoyState              m_state;
+};
+
+#endif /* FEEDER_HPP */
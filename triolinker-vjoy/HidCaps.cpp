@@ -0,0 +1,164 @@
+/**
+ * triolinker-vjoy
+ * Input field layout from HID preparsed data.
+ */
+
+#include <algorithm>
+
+#include "HidCaps.hpp"
+
+// Main item flag for variable (as opposed to array) data.
+constexpr USHORT HID_MAIN_VARIABLE = 0x02;
+
+/**
+ * Locate the bits set in a probe report.
+ * The HID API doesn't expose field positions, so each field is written into
+ * an empty report with HidP_SetUsageValue/HidP_SetUsages and found again here.
+ * @param report Probe report.
+ * @param field Field to receive the bit offset.
+ * @return True if exactly bitSize contiguous bits were found.
+ */
+static bool locateField(const std::vector<uint8_t>& report, HidField& field)
+{
+	size_t first = 0;
+	size_t count = 0;
+
+	// Skip the report ID byte.
+	for (size_t bit = 8; bit < report.size() * 8; bit++)
+	{
+		if (report[bit / 8] & (1 << (bit % 8)))
+		{
+			if (!count)
+			{
+				first = bit;
+			}
+			else if (bit - first != count)
+			{
+				// A gap: the bits don't form a single field.
+				return false;
+			}
+
+			++count;
+		}
+	}
+
+	if (!count || count != field.bitSize || first > 0xFFFF)
+	{
+		return false;
+	}
+
+	field.bitOffset = static_cast<uint16_t>(first);
+	return true;
+}
+
+/**
+ * Get the position and range of every input value and button of a device.
+ * @param data Preparsed data of the device.
+ * @param caps Capabilities of the device.
+ * @return Input fields. Fields that couldn't be located are left out.
+ */
+std::vector<HidField> readInputFields(PHIDP_PREPARSED_DATA data, const HIDP_CAPS& caps)
+{
+	std::vector<HidField> fields;
+	std::vector<uint8_t>  report(caps.InputReportByteLength);
+	const auto            length = static_cast<ULONG>(report.size());
+
+	USHORT valueCount = caps.NumberInputValueCaps;
+	std::vector<HIDP_VALUE_CAPS> valueCaps(valueCount);
+
+	if (valueCount && HidP_GetValueCaps(HidP_Input, valueCaps.data(), &valueCount, data) != HIDP_STATUS_SUCCESS)
+	{
+		valueCount = 0;
+	}
+
+	for (USHORT i = 0; i < valueCount; i++)
+	{
+		const HIDP_VALUE_CAPS& cap = valueCaps[i];
+
+		if (cap.BitSize == 0 || cap.BitSize > 32 || (!cap.IsRange && cap.ReportCount != 1))
+		{
+			continue;
+		}
+
+		const USAGE first = cap.IsRange ? cap.Range.UsageMin : cap.NotRange.Usage;
+		const USAGE last  = cap.IsRange ? cap.Range.UsageMax : cap.NotRange.Usage;
+		const ULONG ones  = cap.BitSize == 32 ? 0xFFFFFFFF : (1ul << cap.BitSize) - 1;
+
+		for (ULONG usage = first; usage <= last; usage++)
+		{
+			std::fill(report.begin(), report.end(), 0);
+			report[0] = cap.ReportID;
+
+			if (HidP_SetUsageValue(HidP_Input, cap.UsagePage, cap.LinkCollection, static_cast<USAGE>(usage), ones, data,
+			                       reinterpret_cast<PCHAR>(report.data()), length) != HIDP_STATUS_SUCCESS)
+			{
+				continue;
+			}
+
+			HidField field;
+			field.usagePage  = cap.UsagePage;
+			field.usage      = static_cast<uint16_t>(usage);
+			field.reportId   = cap.ReportID;
+			field.bitSize    = static_cast<uint8_t>(cap.BitSize);
+			field.logicalMin = cap.LogicalMin;
+			field.logicalMax = cap.LogicalMax;
+
+			if (locateField(report, field))
+			{
+				fields.push_back(field);
+			}
+		}
+	}
+
+	USHORT buttonCount = caps.NumberInputButtonCaps;
+	std::vector<HIDP_BUTTON_CAPS> buttonCaps(buttonCount);
+
+	if (buttonCount && HidP_GetButtonCaps(HidP_Input, buttonCaps.data(), &buttonCount, data) != HIDP_STATUS_SUCCESS)
+	{
+		buttonCount = 0;
+	}
+
+	for (USHORT i = 0; i < buttonCount; i++)
+	{
+		const HIDP_BUTTON_CAPS& cap = buttonCaps[i];
+
+		// Button arrays report the index of pressed buttons rather than one bit per button.
+		if (!(cap.BitField & HID_MAIN_VARIABLE))
+		{
+			continue;
+		}
+
+		const USAGE first = cap.IsRange ? cap.Range.UsageMin : cap.NotRange.Usage;
+		const USAGE last  = cap.IsRange ? cap.Range.UsageMax : cap.NotRange.Usage;
+
+		for (ULONG usage = first; usage <= last; usage++)
+		{
+			std::fill(report.begin(), report.end(), 0);
+			report[0] = cap.ReportID;
+
+			USAGE probe = static_cast<USAGE>(usage);
+			ULONG probeCount = 1;
+
+			if (HidP_SetUsages(HidP_Input, cap.UsagePage, cap.LinkCollection, &probe, &probeCount, data,
+			                   reinterpret_cast<PCHAR>(report.data()), length) != HIDP_STATUS_SUCCESS)
+			{
+				continue;
+			}
+
+			HidField field;
+			field.usagePage  = cap.UsagePage;
+			field.usage      = static_cast<uint16_t>(usage);
+			field.reportId   = cap.ReportID;
+			field.bitSize    = 1;
+			field.logicalMin = 0;
+			field.logicalMax = 1;
+
+			if (locateField(report, field))
+			{
+				fields.push_back(field);
+			}
+		}
+	}
+
+	return fields;
+}
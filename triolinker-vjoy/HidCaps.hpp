@@ -0,0 +1,19 @@
+/**
+ * triolinker-vjoy
+ * Input field layout from HID preparsed data.
+ */
+
+#ifndef HIDCAPS_HPP
+#define HIDCAPS_HPP
+
+#include <vector>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <hidsdi.h>
+
+#include "DecodePlan.hpp"
+
+std::vector<HidField> readInputFields(PHIDP_PREPARSED_DATA data, const HIDP_CAPS& caps);
+
+#endif /* HIDCAPS_HPP */
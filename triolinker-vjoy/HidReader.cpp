@@ -0,0 +1,155 @@
+/**
+ * triolinker-vjoy
+ * HID input report reader.
+ */
+
+#include <cstring>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <hidsdi.h>
+
+#include "HidReader.hpp"
+
+/**
+ * @param handle HID device handle.
+ * @param reportLength Input report length, including the report ID.
+ * @param pendingReads Number of overlapped reads to keep queued, or 0 for blocking reads.
+ */
+HidReader::HidReader(HANDLE handle, size_t reportLength, size_t pendingReads)
+	: m_handle(handle),
+	  m_reportLength(reportLength),
+	  m_requests(pendingReads)
+{
+	for (auto& request : m_requests)
+	{
+		request.overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		request.buffer.resize(reportLength);
+		post(request);
+	}
+}
+
+HidReader::~HidReader()
+{
+	cancel();
+
+	for (auto& request : m_requests)
+	{
+		CloseHandle(request.overlapped.hEvent);
+	}
+}
+
+size_t HidReader::reportLength() const
+{
+	return m_reportLength;
+}
+
+/**
+ * Read the next input report.
+ * @param report Destination buffer of at least reportLength bytes.
+ * @return True on success, false if the device failed or was disconnected.
+ */
+bool HidReader::read(uint8_t* report)
+{
+	DWORD dummy;
+
+	if (m_requests.empty())
+	{
+		return !!ReadFile(m_handle, report, static_cast<DWORD>(m_reportLength), &dummy, nullptr);
+	}
+
+	Request& request = m_requests[m_next];
+
+	if (!request.pending)
+	{
+		return false;
+	}
+
+	request.pending = false;
+
+	if (!GetOverlappedResult(m_handle, &request.overlapped, &dummy, TRUE))
+	{
+		return false;
+	}
+
+	memcpy(report, request.buffer.data(), m_reportLength);
+
+	// Re-queue immediately so the same number of reads stays outstanding while the caller works.
+	post(request);
+	m_next = (m_next + 1) % m_requests.size();
+	return true;
+}
+
+/**
+ * Check if the next report can be read without waiting.
+ * Always false for blocking reads.
+ * @return True if the next queued read has already completed.
+ */
+bool HidReader::ready() const
+{
+	if (m_requests.empty())
+	{
+		return false;
+	}
+
+	const Request& request = m_requests[m_next];
+	return request.pending && HasOverlappedIoCompleted(&request.overlapped);
+}
+
+/**
+ * Discard queued reports, both in the driver's input buffer and in reads that already completed.
+ */
+void HidReader::flush()
+{
+	cancel();
+	HidD_FlushQueue(m_handle);
+
+	for (auto& request : m_requests)
+	{
+		post(request);
+	}
+
+	m_next = 0;
+}
+
+/**
+ * Only available with pending reads; blocking reads have nothing to wait on.
+ * @return Device handle the queued reads are posted on.
+ */
+WaitHandle HidReader::waitHandle() const
+{
+	return m_requests.empty() ? INVALID_WAIT_HANDLE : m_handle;
+}
+
+/**
+ * Cancel the queued reads and wait for them to finish.
+ * The reads may have been posted by another thread, such as an event loop
+ * worker, so each one is cancelled by its OVERLAPPED rather than with CancelIo.
+ */
+void HidReader::cancel()
+{
+	for (auto& request : m_requests)
+	{
+		if (request.pending)
+		{
+			DWORD dummy;
+			CancelIoEx(m_handle, &request.overlapped);
+			GetOverlappedResult(m_handle, &request.overlapped, &dummy, TRUE);
+			request.pending = false;
+		}
+	}
+}
+
+bool HidReader::post(Request& request)
+{
+	ResetEvent(request.overlapped.hEvent);
+
+	if (!ReadFile(m_handle, request.buffer.data(), static_cast<DWORD>(m_reportLength), nullptr, &request.overlapped) &&
+	    GetLastError() != ERROR_IO_PENDING)
+	{
+		return false;
+	}
+
+	request.pending = true;
+	return true;
+}
@@ -0,0 +1,54 @@
+/**
+ * triolinker-vjoy
+ * HID input report reader.
+ */
+
+#ifndef HIDREADER_HPP
+#define HIDREADER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "ReportSource.hpp"
+
+/**
+ * Reads input reports from a HID handle.
+ * With pending reads enabled the handle must be opened with FILE_FLAG_OVERLAPPED;
+ * that many reads are kept queued at all times and completed in the order they were issued.
+ */
+class HidReader : public ReportSource
+{
+public:
+	HidReader(HANDLE handle, size_t reportLength, size_t pendingReads);
+	~HidReader();
+
+	HidReader(const HidReader&) = delete;
+	HidReader& operator=(const HidReader&) = delete;
+
+	size_t reportLength() const override;
+	bool read(uint8_t* report) override;
+	bool ready() const override;
+	void flush() override;
+	WaitHandle waitHandle() const override;
+
+protected:
+	struct Request
+	{
+		OVERLAPPED           overlapped {};
+		std::vector<uint8_t> buffer;
+		bool                 pending = false;
+	};
+
+	void cancel();
+	bool post(Request& request);
+
+	HANDLE               m_handle;
+	size_t               m_reportLength;
+	std::vector<Request> m_requests;
+	size_t               m_next = 0;
+};
+
+#endif /* HIDREADER_HPP */
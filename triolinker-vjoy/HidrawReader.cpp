@@ -0,0 +1,217 @@
+/**
+ * triolinker-vjoy
+ * Linux hidraw input report reader.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <linux/hidraw.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "HidrawReader.hpp"
+
+/**
+ * @param fd hidraw descriptor, opened with O_NONBLOCK. Owned by the reader.
+ * @param reportLength Size of the largest input report, including the report ID byte.
+ * @param reportIds True if the device prefixes its reports with a report ID.
+ */
+HidrawReader::HidrawReader(int fd, size_t reportLength, bool reportIds)
+	: m_fd(fd),
+	  m_epoll(epoll_create1(EPOLL_CLOEXEC)),
+	  m_reportLength(reportLength),
+	  m_reportIds(reportIds)
+{
+	epoll_event event {};
+	event.events  = EPOLLIN;
+	event.data.fd = m_fd;
+
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_fd, &event);
+}
+
+HidrawReader::~HidrawReader()
+{
+	if (m_epoll >= 0)
+	{
+		close(m_epoll);
+	}
+
+	close(m_fd);
+}
+
+size_t HidrawReader::reportLength() const
+{
+	return m_reportLength;
+}
+
+/**
+ * Read the next input report.
+ * @param report Destination buffer of at least reportLength bytes.
+ * @return True on success, false if the device failed or was disconnected.
+ */
+bool HidrawReader::read(uint8_t* report)
+{
+	uint8_t*     dest   = m_reportIds ? report : report + 1;
+	const size_t length = m_reportIds ? m_reportLength : m_reportLength - 1;
+
+	for (;;)
+	{
+		const ssize_t result = ::read(m_fd, dest, length);
+
+		if (result > 0)
+		{
+			if (!m_reportIds)
+			{
+				report[0] = 0;
+			}
+
+			// Shorter reports from other report IDs leave the tail cleared.
+			std::fill(dest + result, dest + length, 0);
+			return true;
+		}
+
+		if (result == 0 || (errno != EAGAIN && errno != EINTR))
+		{
+			return false;
+		}
+
+		epoll_event event {};
+
+		if (epoll_wait(m_epoll, &event, 1, -1) < 0 && errno != EINTR)
+		{
+			return false;
+		}
+
+		// Reports still buffered at disconnect are read before failing.
+		if ((event.events & (EPOLLERR | EPOLLHUP)) && !(event.events & EPOLLIN))
+		{
+			return false;
+		}
+	}
+}
+
+/**
+ * Check if the next report can be read without waiting.
+ * @return True if a report is already waiting in the hidraw buffer.
+ */
+bool HidrawReader::ready() const
+{
+	epoll_event event {};
+	return epoll_wait(m_epoll, &event, 1, 0) > 0 && (event.events & EPOLLIN);
+}
+
+/**
+ * Drain the hidraw buffer.
+ */
+void HidrawReader::flush()
+{
+	std::vector<uint8_t> scratch(m_reportLength);
+
+	while (::read(m_fd, scratch.data(), scratch.size()) > 0)
+	{
+	}
+}
+
+/**
+ * @return The hidraw descriptor.
+ */
+WaitHandle HidrawReader::waitHandle() const
+{
+	return m_fd;
+}
+
+/**
+ * Open a hidraw device if it has the given IDs.
+ * @param path Device path.
+ * @param vendorID USB vendor ID.
+ * @param productID USB product ID.
+ * @return Non-blocking descriptor, or -1 if the device could not be opened or has other IDs.
+ */
+int openHidrawPath(const std::string& path, int vendorID, int productID)
+{
+	const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	hidraw_devinfo info {};
+
+	if (ioctl(fd, HIDIOCGRAWINFO, &info) == 0 &&
+	    static_cast<uint16_t>(info.vendor) == vendorID &&
+	    static_cast<uint16_t>(info.product) == productID)
+	{
+		return fd;
+	}
+
+	close(fd);
+	return -1;
+}
+
+/**
+ * Find and open the first hidraw device with the given IDs.
+ * @param vendorID USB vendor ID.
+ * @param productID USB product ID.
+ * @param filter Text the device path must contain, or empty for any path.
+ * @param exclude Paths to skip, such as those of devices already opened.
+ * @param path Receives the device path.
+ * @return Non-blocking descriptor, or -1 if no matching device could be opened.
+ */
+int openHidraw(int vendorID, int productID, const std::string& filter, const std::vector<std::string>& exclude, std::string& path)
+{
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::directory_iterator("/dev", error))
+	{
+		const std::string name = entry.path().filename().string();
+
+		if (name.rfind("hidraw", 0) != 0 || entry.path().string().find(filter) == std::string::npos ||
+		    std::find(exclude.begin(), exclude.end(), entry.path().string()) != exclude.end())
+		{
+			continue;
+		}
+
+		const int fd = openHidrawPath(entry.path().string(), vendorID, productID);
+
+		if (fd >= 0)
+		{
+			path = entry.path().string();
+			return fd;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Read the report descriptor of a hidraw device.
+ * @param fd hidraw descriptor.
+ * @param descriptor Receives the report descriptor.
+ * @return True on success.
+ */
+bool readReportDescriptor(int fd, std::vector<uint8_t>& descriptor)
+{
+	int size = 0;
+
+	if (ioctl(fd, HIDIOCGRDESCSIZE, &size) < 0 || size <= 0)
+	{
+		return false;
+	}
+
+	hidraw_report_descriptor raw {};
+	raw.size = std::min<uint32_t>(static_cast<uint32_t>(size), HID_MAX_DESCRIPTOR_SIZE);
+
+	if (ioctl(fd, HIDIOCGRDESC, &raw) < 0)
+	{
+		return false;
+	}
+
+	descriptor.assign(raw.value, raw.value + raw.size);
+	return true;
+}
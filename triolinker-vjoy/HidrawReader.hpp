@@ -0,0 +1,47 @@
+/**
+ * triolinker-vjoy
+ * Linux hidraw input report reader.
+ */
+
+#ifndef HIDRAWREADER_HPP
+#define HIDRAWREADER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ReportSource.hpp"
+
+/**
+ * Reads input reports from a non-blocking /dev/hidraw* descriptor,
+ * sleeping in epoll until the next report arrives.
+ * Reports from devices without report IDs are prefixed with a 0 byte,
+ * so buffer offsets in config.ini are the same as on Windows.
+ */
+class HidrawReader : public ReportSource
+{
+public:
+	HidrawReader(int fd, size_t reportLength, bool reportIds);
+	~HidrawReader() override;
+
+	HidrawReader(const HidrawReader&) = delete;
+	HidrawReader& operator=(const HidrawReader&) = delete;
+
+	size_t reportLength() const override;
+	bool read(uint8_t* report) override;
+	bool ready() const override;
+	void flush() override;
+	WaitHandle waitHandle() const override;
+
+protected:
+	int    m_fd;
+	int    m_epoll;
+	size_t m_reportLength;
+	bool   m_reportIds;
+};
+
+int openHidrawPath(const std::string& path, int vendorID, int productID);
+int openHidraw(int vendorID, int productID, const std::string& filter, const std::vector<std::string>& exclude, std::string& path);
+bool readReportDescriptor(int fd, std::vector<uint8_t>& descriptor);
+
+#endif /* HIDRAWREADER_HPP */
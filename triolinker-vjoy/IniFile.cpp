@@ -10,8 +10,11 @@
 #include <array>
 #include <cctype>
 #include <fstream>
+#include <list>
 
+#ifdef _WIN32
 #include "windows.h"
+#endif
 
 /** IniGroup **/
 
@@ -54,6 +57,7 @@ std::string IniGroup::getString(const std::string& key, const std::string& def)
 	return it != m_data.end() ? it->second : def;
 }
 
+#ifdef _WIN32
 /**
  * Get a wide std::string value from the INI group.
  * INI strings are converted from UTF-8 to UTF-16.
@@ -73,6 +77,7 @@ std::wstring IniGroup::getWString(const std::string& key, const std::wstring& de
 	// Convert the std::string from UTF-8 to UTF-16.
 	return MBStoUTF16(it->second, CP_UTF8);
 }
+#endif
 
 /**
  * Get a boolean value from the INI group.
@@ -154,6 +159,7 @@ void IniGroup::setString(const std::string& key, const std::string& val)
 	m_data[key] = val;
 }
 
+#ifdef _WIN32
 /**
 * Set a wide std::string value in the INI group.
 * INI strings are converted from UTF-8 to UTF-16.
@@ -164,6 +170,7 @@ void IniGroup::setWString(const std::string& key, const std::wstring& val)
 {
 	m_data[key] = UTF16toMBS(val, CP_UTF8);
 }
+#endif
 
 /**
 * Set a boolean value in the INI group.
@@ -192,13 +199,13 @@ void IniGroup::setIntRadix(const std::string& key, int radix, int value)
 	switch (radix)
 	{
 	case 8:
-		snprintf(buf, buf.size(), "%o", value);
+		snprintf(buf.data(), buf.size(), "%o", value);
 		break;
 	case 16:
-		snprintf(buf, buf.size(), "%x", value);
+		snprintf(buf.data(), buf.size(), "%x", value);
 		break;
 	default:
-		snprintf(buf, buf.size(), "%d", value);
+		snprintf(buf.data(), buf.size(), "%d", value);
 		break;
 	}
 #endif
@@ -276,6 +283,7 @@ IniFile::IniFile(const std::string& filename)
 	load(f);
 }
 
+#ifdef _WIN32
 IniFile::IniFile(const std::wstring& filename)
 {
 	std::ifstream f(filename);
@@ -287,6 +295,7 @@ IniFile::IniFile(const std::wstring& filename)
 
 	load(f);
 }
+#endif
 
 IniFile::IniFile(std::istream& f)
 {
@@ -398,6 +407,7 @@ std::string IniFile::getString(const std::string& section, const std::string& ke
 	return group ? group->getString(key, def) : def;
 }
 
+#ifdef _WIN32
 /**
  * Get a wide std::string value from the INI group.
  * INI strings are converted from UTF-8 to UTF-16.
@@ -411,6 +421,7 @@ std::wstring IniFile::getWString(const std::string& section, const std::string&
 	const IniGroup* group = getGroup(section);
 	return group ? group->getWString(key, def) : def;
 }
+#endif
 
 /**
  * Get a boolean value from the INI file.
@@ -476,6 +487,7 @@ void IniFile::setString(const std::string& section, const std::string& key, cons
 	createGroup(section)->setString(key, val);
 }
 
+#ifdef _WIN32
 /**
 * Set a wide std::string value in the INI file.
 * INI strings are converted from UTF-8 to UTF-16.
@@ -487,6 +499,7 @@ void IniFile::setWString(const std::string& section, const std::string& key, con
 {
 	createGroup(section)->setWString(key, val);
 }
+#endif
 
 /**
 * Set a boolean value in the INI file.
@@ -579,6 +592,7 @@ void IniFile::save(const std::string& filename) const
 	save(f);
 }
 
+#ifdef _WIN32
 /**
 * Save an INI file.
 * @param filename Name of file to save to.
@@ -594,6 +608,7 @@ void IniFile::save(const std::wstring& filename) const
 
 	save(f);
 }
+#endif
 
 /**
 * Save an INI file.
@@ -24,14 +24,18 @@ public:
 	const std::unordered_map<std::string, std::string>* data() const;
 
 	std::string getString(const std::string& key, const std::string& def = "") const;
+#ifdef _WIN32
 	std::wstring getWString(const std::string& key, const std::wstring& def = L"") const;
+#endif
 	bool getBool(const std::string& key, bool def = false) const;
 	int getIntRadix(const std::string& key, int radix, int def = 0) const;
 	int getInt(const std::string& key, int def = 0) const;
 	float getFloat(const std::string& key, float def = 0) const;
 
 	void setString(const std::string& key, const std::string& val);
+#ifdef _WIN32
 	void setWString(const std::string& key, const std::wstring& val);
+#endif
 	void setBool(const std::string& key, bool val);
 	void setIntRadix(const std::string& key, int radix, int value);
 	void setInt(const std::string& key, int val);
@@ -63,7 +67,9 @@ class IniFile
 {
 public:
 	explicit IniFile(const std::string& filename);
+#ifdef _WIN32
 	explicit IniFile(const std::wstring& filename);
+#endif
 	explicit IniFile(std::istream& f);
 	~IniFile();
 
@@ -76,14 +82,18 @@ public:
 	bool hasKeyNonEmpty(const std::string& section, const std::string& key) const;
 
 	std::string getString(const std::string& section, const std::string& key, const std::string& def = "") const;
+#ifdef _WIN32
 	std::wstring getWString(const std::string& section, const std::string& key, const std::wstring& def = L"") const;
+#endif
 	bool getBool(const std::string& section, const std::string& key, bool def = false) const;
 	int getIntRadix(const std::string& section, const std::string& key, int radix, int def = 0) const;
 	int getInt(const std::string& section, const std::string& key, int def = 0) const;
 	float getFloat(const std::string& section, const std::string& key, float def = 0) const;
 
 	void setString(const std::string& section, const std::string& key, const std::string& val);
+#ifdef _WIN32
 	void setWString(const std::string& section, const std::string& key, const std::wstring& val);
+#endif
 	void setBool(const std::string& section, const std::string& key, bool val);
 	void setIntRadix(const std::string& section, const std::string& key, int radix, int val);
 	void setInt(const std::string& section, const std::string& key, int val);
@@ -93,7 +103,9 @@ public:
 	bool removeKey(const std::string& section, const std::string& key);
 
 	void save(const std::string& filename) const;
+#ifdef _WIN32
 	void save(const std::wstring& filename) const;
+#endif
 	void save(std::fstream& f) const;
 
 	std::unordered_map<std::string, IniGroup*>::iterator begin();
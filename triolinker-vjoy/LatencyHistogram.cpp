@@ -0,0 +1,122 @@
+/**
+ * triolinker-vjoy
+ * Fixed-bucket latency histogram.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+
+#include "LatencyHistogram.hpp"
+
+/**
+ * Add a value.
+ * @param value Latency in nanoseconds.
+ */
+void LatencyHistogram::record(uint64_t value)
+{
+	// Single writer, so plain load/store pairs are enough and avoid locked instructions.
+	std::atomic<uint64_t>& counter = m_counts[bucket(value)];
+	counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	if (value > m_max.load(std::memory_order_relaxed))
+	{
+		m_max.store(value, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * @return Number of recorded values.
+ */
+uint64_t LatencyHistogram::count() const
+{
+	return m_count.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return Largest recorded value.
+ */
+uint64_t LatencyHistogram::max() const
+{
+	return m_max.load(std::memory_order_relaxed);
+}
+
+/**
+ * Get the value at a percentile.
+ * @param percent Percentile (0-100).
+ * @return Upper bound of the bucket holding the percentile, or 0 if nothing was recorded.
+ */
+uint64_t LatencyHistogram::percentile(double percent) const
+{
+	uint64_t total = 0;
+
+	for (const auto& counter : m_counts)
+	{
+		total += counter.load(std::memory_order_relaxed);
+	}
+
+	if (total == 0)
+	{
+		return 0;
+	}
+
+	const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(total) * percent / 100.0 + 0.5));
+	uint64_t   seen   = 0;
+
+	for (size_t i = 0; i < BUCKET_COUNT; i++)
+	{
+		seen += m_counts[i].load(std::memory_order_relaxed);
+
+		if (seen >= target)
+		{
+			return std::min(upperBound(i), max());
+		}
+	}
+
+	return max();
+}
+
+/**
+ * Print the report count, p50, p99, p99.9 and max in microseconds.
+ * @param stream Output stream.
+ */
+void LatencyHistogram::print(std::ostream& stream) const
+{
+	const auto us = [](uint64_t ns)
+	{
+		return static_cast<double>(ns) / 1000.0;
+	};
+
+	stream << std::dec << std::fixed << std::setprecision(1)
+	       << "Latency over " << count() << " reports (us):"
+	       << " p50 " << us(percentile(50.0))
+	       << ", p99 " << us(percentile(99.0))
+	       << ", p99.9 " << us(percentile(99.9))
+	       << ", max " << us(max()) << std::endl;
+}
+
+size_t LatencyHistogram::bucket(uint64_t value)
+{
+	if (value < LINEAR)
+	{
+		return static_cast<size_t>(value);
+	}
+
+	// Keep the top SUB_BITS + 1 bits; the highest one is implied by the magnitude.
+	const size_t shift = std::bit_width(value) - (SUB_BITS + 1);
+	return LINEAR + (shift - 1) * SUB_COUNT + static_cast<size_t>((value >> shift) - SUB_COUNT);
+}
+
+uint64_t LatencyHistogram::upperBound(size_t index)
+{
+	if (index < LINEAR)
+	{
+		return index;
+	}
+
+	const size_t   shift = (index - LINEAR) / SUB_COUNT + 1;
+	const uint64_t sub   = SUB_COUNT + (index - LINEAR) % SUB_COUNT;
+
+	return ((sub + 1) << shift) - 1;
+}
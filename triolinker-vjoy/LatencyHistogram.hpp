@@ -0,0 +1,45 @@
+/**
+ * triolinker-vjoy
+ * Fixed-bucket latency histogram.
+ */
+
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Log-linear histogram of nanosecond values, in the style of HdrHistogram:
+ * exact below 64 ns, then 32 buckets per power of two (at most ~3% error).
+ * All storage is inline, so recording never allocates.
+ * Values are recorded by a single thread and may be read from any thread.
+ */
+class LatencyHistogram
+{
+public:
+	void record(uint64_t value);
+
+	uint64_t count() const;
+	uint64_t max() const;
+	uint64_t percentile(double percent) const;
+
+	void print(std::ostream& stream) const;
+
+protected:
+	static constexpr size_t SUB_BITS     = 5;
+	static constexpr size_t SUB_COUNT    = static_cast<size_t>(1) << SUB_BITS;
+	static constexpr size_t LINEAR       = SUB_COUNT * 2; // values below this have their own bucket
+	static constexpr size_t BUCKET_COUNT = LINEAR + (64 - (SUB_BITS + 1)) * SUB_COUNT;
+
+	static size_t bucket(uint64_t value);
+	static uint64_t upperBound(size_t index);
+
+	std::atomic<uint64_t> m_counts[BUCKET_COUNT] {};
+	std::atomic<uint64_t> m_count { 0 };
+	std::atomic<uint64_t> m_max { 0 };
+};
+
+#endif /* LATENCYHISTOGRAM_HPP */
@@ -0,0 +1,92 @@
+/**
+ * triolinker-vjoy
+ * Decoded state output interface.
+ */
+
+#ifndef OUTPUTSINK_HPP
+#define OUTPUTSINK_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "DecodePlan.hpp"
+#include "Stats.hpp"
+
+/**
+ * Receives decoded controller states.
+ */
+class OutputSink
+{
+public:
+	virtual ~OutputSink() = default;
+
+	/**
+	 * Get the logical range the sink expects for an axis.
+	 * @param axis Axis index (0-based).
+	 * @return Logical range.
+	 */
+	virtual AxisRange axisRange(size_t /*axis*/) const
+	{
+		return {};
+	}
+
+	/**
+	 * Send a state to the output device.
+	 * @param state Decoded state.
+	 */
+	virtual void commit(const JoyState& state) = 0;
+
+	/**
+	 * Bring the output device to rest: axes centered, buttons released and the POV centered.
+	 * Used while the input device is disconnected.
+	 */
+	virtual void reset()
+	{
+		JoyState state;
+
+		for (size_t i = 0; i < AXIS_COUNT; i++)
+		{
+			const AxisRange range = axisRange(i);
+			state.axes[i] = range.min + (range.max - range.min) / 2;
+		}
+
+		commit(state);
+	}
+
+	/**
+	 * Count every call the sink makes into the output driver or the system from now on.
+	 * @param counter Counter to increment, or nullptr to stop counting.
+	 * @param concurrent True if other threads increment the same counter.
+	 */
+	void countCalls(std::atomic<uint64_t>* counter, bool concurrent)
+	{
+		m_calls           = counter;
+		m_concurrentCalls = concurrent;
+	}
+
+protected:
+	/**
+	 * Count one call into the output driver or the system.
+	 */
+	void called()
+	{
+		if (m_calls == nullptr)
+		{
+			return;
+		}
+
+		if (m_concurrentCalls)
+		{
+			add(*m_calls);
+		}
+		else
+		{
+			bump(*m_calls);
+		}
+	}
+
+	std::atomic<uint64_t>* m_calls           = nullptr;
+	bool                   m_concurrentCalls = false;
+};
+
+#endif /* OUTPUTSINK_HPP */
@@ -0,0 +1,277 @@
+/**
+ * triolinker-vjoy
+ * Checks a list of candidates on a few threads at once.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "ParallelProbe.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * One call to probe(). Threads still checking a candidate after the call
+ * returned keep it alive until they are done.
+ */
+struct ProbePool::Job
+{
+	ProbeFunction probe;
+	size_t        count   = 0;
+	size_t        workers = 0; // candidates checked at once, not counting those given up on
+
+	size_t                         next     = 0;        // next candidate to hand out
+	size_t                         active   = 0;        // candidates handed out and not yet checked or given up on
+	size_t                         finished = 0;        // candidates checked or given up on
+	size_t                         first    = SIZE_MAX; // lowest candidate found to match
+	std::vector<bool>              ended;               // per candidate: checked or given up on
+	std::vector<bool>              matched;
+	std::vector<Clock::time_point> started;
+};
+
+/**
+ * State shared by the pool and its threads. A thread detached while inside a
+ * probe keeps it alive until the probe returns.
+ */
+struct ProbePool::Shared
+{
+	std::mutex                        mutex;
+	std::condition_variable           work;    // a job was added, a candidate was given up on, or the pool is stopping
+	std::condition_variable           changed; // a candidate was handed out or checked, or a thread came back
+	std::vector<std::shared_ptr<Job>> jobs;
+	std::vector<bool>                 busy;        // per thread: inside a probe
+	size_t                            stuck   = 0; // threads still checking a candidate that was given up on
+	bool                              stopped = false;
+};
+
+/**
+ * @param threads Number of threads, including those left checking candidates that were given up on.
+ */
+ProbePool::ProbePool(size_t threads)
+	: m_shared(std::make_shared<Shared>())
+{
+	threads = std::max<size_t>(threads, 1);
+	m_shared->busy.resize(threads);
+
+	for (size_t i = 0; i < threads; i++)
+	{
+		m_threads.emplace_back(&ProbePool::work, m_shared, i);
+	}
+}
+
+/**
+ * Stop the threads. A thread still inside a probe, such as one waiting on a
+ * device that never answers, is detached rather than joined; it stops once
+ * the probe returns, or with the process.
+ */
+ProbePool::~ProbePool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_shared->mutex);
+		m_shared->stopped = true;
+
+		// No job is left, so a thread that is idle now stops as soon as it wakes up.
+		for (size_t i = 0; i < m_threads.size(); i++)
+		{
+			if (m_shared->busy[i])
+			{
+				m_threads[i].detach();
+			}
+		}
+	}
+
+	m_shared->work.notify_all();
+
+	for (auto& thread : m_threads)
+	{
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+}
+
+/**
+ * Check candidates on up to workers threads at once. A candidate still being
+ * checked after the timeout is given up on, and counts as not matching. If
+ * every thread of the pool is left checking such candidates, the ones not yet
+ * handed out are given up on too. Because of that, the probe function may
+ * still be running after this returns, even after the pool is destroyed: it is
+ * kept alive until then, and must only refer to what it owns.
+ * Looking for one match ends as soon as a candidate matches and every one
+ * before it was checked or given up on, so the result doesn't depend on
+ * which probe happened to return first.
+ * @param count Number of candidates.
+ * @param probe Function checking one candidate.
+ * @param workers Number of candidates checked at once.
+ * @param timeout Time after which a candidate is given up on.
+ * @param all True to return every match, false to look for the first one.
+ * @return Indices of the matching candidates in ascending order, or only the first one.
+ */
+std::vector<size_t> ProbePool::probe(size_t count, ProbeFunction probe, size_t workers, std::chrono::milliseconds timeout, bool all)
+{
+	std::vector<size_t> result;
+
+	if (count == 0)
+	{
+		return result;
+	}
+
+	auto job = std::make_shared<Job>();
+
+	job->probe   = std::move(probe);
+	job->count   = count;
+	job->workers = std::max<size_t>(workers, 1);
+	job->ended.resize(count);
+	job->matched.resize(count);
+	job->started.resize(count);
+
+	// True once no candidate before the first match can still match.
+	const auto settled = [&job]
+	{
+		return job->first != SIZE_MAX && std::all_of(job->ended.begin(), job->ended.begin() + job->first, [](bool ended) { return ended; });
+	};
+
+	Shared&                      shared = *m_shared;
+	std::unique_lock<std::mutex> lock(shared.mutex);
+
+	shared.jobs.push_back(job);
+	shared.work.notify_all();
+
+	while (job->finished < job->count && (all || !settled()))
+	{
+		// Nothing is left to check the rest.
+		if (shared.stuck == m_threads.size() && job->next < job->count)
+		{
+			job->finished += job->count - job->next;
+			job->next      = job->count;
+			continue;
+		}
+
+		// Only the candidates handed out and not yet finished can time out.
+		auto deadline = Clock::time_point::max();
+
+		for (size_t i = 0; i < job->next; i++)
+		{
+			if (!job->ended[i])
+			{
+				deadline = std::min(deadline, job->started[i] + timeout);
+			}
+		}
+
+		if (deadline == Clock::time_point::max())
+		{
+			shared.changed.wait(lock);
+			continue;
+		}
+
+		shared.changed.wait_until(lock, deadline);
+
+		const auto now = Clock::now();
+
+		for (size_t i = 0; i < job->next; i++)
+		{
+			if (!job->ended[i] && now >= job->started[i] + timeout)
+			{
+				job->ended[i] = true;
+				--job->active;
+				++job->finished;
+				++shared.stuck;
+
+				// Another thread takes the stuck one's place, if any is free.
+				shared.work.notify_all();
+			}
+		}
+	}
+
+	shared.jobs.erase(std::find(shared.jobs.begin(), shared.jobs.end(), job));
+
+	if (!all)
+	{
+		if (job->first != SIZE_MAX)
+		{
+			result.push_back(job->first);
+		}
+
+		return result;
+	}
+
+	for (size_t i = 0; i < job->count; i++)
+	{
+		if (job->matched[i])
+		{
+			result.push_back(i);
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Pool thread: check candidates of whichever job has some left, until the pool is destroyed.
+ * @param shared State shared with the pool.
+ * @param thread Index of this thread.
+ */
+void ProbePool::work(std::shared_ptr<Shared> shared, size_t thread)
+{
+	std::unique_lock<std::mutex> lock(shared->mutex);
+
+	for (;;)
+	{
+		std::shared_ptr<Job> job;
+
+		shared->work.wait(lock, [&]
+		{
+			for (const auto& candidate : shared->jobs)
+			{
+				if (candidate->next < candidate->count && candidate->active < candidate->workers)
+				{
+					job = candidate;
+					return true;
+				}
+			}
+
+			return shared->stopped;
+		});
+
+		if (job == nullptr)
+		{
+			return;
+		}
+
+		const size_t index = job->next++;
+		job->started[index] = Clock::now();
+		++job->active;
+
+		// The caller times the candidate from now on.
+		shared->changed.notify_all();
+
+		shared->busy[thread] = true;
+		lock.unlock();
+		const bool match = job->probe(index);
+		lock.lock();
+		shared->busy[thread] = false;
+
+		// The candidate took too long, and was given up on meanwhile.
+		if (job->ended[index])
+		{
+			--shared->stuck;
+		}
+		else
+		{
+			job->ended[index]   = true;
+			job->matched[index] = match;
+			--job->active;
+			++job->finished;
+
+			if (match)
+			{
+				job->first = std::min(job->first, index);
+			}
+		}
+
+		shared->changed.notify_all();
+	}
+}
@@ -0,0 +1,53 @@
+/**
+ * triolinker-vjoy
+ * Checks a list of candidates on a few threads at once.
+ */
+
+#ifndef PARALLELPROBE_HPP
+#define PARALLELPROBE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * Check whether a candidate matches. Called on a worker thread.
+ * @param index Candidate index.
+ * @return True if the candidate matches.
+ */
+using ProbeFunction = std::function<bool(size_t index)>;
+
+/**
+ * A fixed set of threads checking candidates for probe(), so one that is
+ * slow to answer doesn't hold up the rest. A candidate still being checked
+ * after the timeout is given up on, and its thread is left to finish it;
+ * meanwhile the other threads carry on. The threads are started once. When
+ * the pool is destroyed, idle threads are joined and threads still inside a
+ * probe are detached, so a device that never answers can't hold up exit.
+ * probe() may be called from several threads at once.
+ */
+class ProbePool
+{
+public:
+	explicit ProbePool(size_t threads);
+	~ProbePool();
+
+	ProbePool(const ProbePool&) = delete;
+	ProbePool& operator=(const ProbePool&) = delete;
+
+	std::vector<size_t> probe(size_t count, ProbeFunction probe, size_t workers, std::chrono::milliseconds timeout, bool all);
+
+protected:
+	struct Job;
+	struct Shared;
+
+	static void work(std::shared_ptr<Shared> shared, size_t thread);
+
+	std::shared_ptr<Shared>  m_shared; // also held by the threads, which may outlive the pool
+	std::vector<std::thread> m_threads;
+};
+
+#endif /* PARALLELPROBE_HPP */
@@ -0,0 +1,250 @@
+/**
+ * triolinker-vjoy
+ * Report source replaying a capture file.
+ */
+
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Capture.hpp"
+#include "ReplaySource.hpp"
+
+/**
+ * Map a capture file. Check valid() before use.
+ * @param path Capture file path.
+ * @param realTime True to wait for each report's original timestamp,
+ * false to return reports as fast as they are read.
+ */
+ReplaySource::ReplaySource(const std::string& path, bool realTime)
+	: m_realTime(realTime)
+{
+#ifdef _WIN32
+	const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER size {};
+	const HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+		? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+		: nullptr;
+
+	CloseHandle(file);
+
+	if (mapping == nullptr)
+	{
+		return;
+	}
+
+	// The view keeps the mapping alive.
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);
+
+	if (m_data == nullptr)
+	{
+		return;
+	}
+
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		return;
+	}
+
+	struct stat info {};
+
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (data != MAP_FAILED)
+		{
+			m_data = static_cast<const uint8_t*>(data);
+			m_size = static_cast<size_t>(info.st_size);
+			madvise(data, m_size, MADV_SEQUENTIAL);
+		}
+	}
+
+	close(fd);
+
+	if (m_data == nullptr)
+	{
+		return;
+	}
+#endif
+
+	CaptureHeader header;
+
+	if (m_size < sizeof(header))
+	{
+		return;
+	}
+
+	std::memcpy(&header, m_data, sizeof(header));
+
+	const size_t fieldBytes = static_cast<size_t>(header.fieldCount) * sizeof(CaptureField);
+
+	if (header.magic != CAPTURE_MAGIC || header.version != CAPTURE_VERSION ||
+	    header.reportLength == 0 || m_size - sizeof(header) < fieldBytes)
+	{
+		return;
+	}
+
+	const uint8_t* fields = m_data + sizeof(header);
+
+	for (uint32_t i = 0; i < header.fieldCount; i++)
+	{
+		CaptureField record;
+		std::memcpy(&record, fields + i * sizeof(record), sizeof(record));
+
+		HidField field;
+		field.usagePage  = record.usagePage;
+		field.usage      = record.usage;
+		field.reportId   = record.reportId;
+		field.bitSize    = record.bitSize;
+		field.bitOffset  = record.bitOffset;
+		field.logicalMin = record.logicalMin;
+		field.logicalMax = record.logicalMax;
+		m_fields.push_back(field);
+	}
+
+	m_reportLength = header.reportLength;
+	m_stride       = sizeof(uint64_t) + m_reportLength;
+	m_records      = fields + fieldBytes;
+
+	// A truncated last record is ignored.
+	m_count = (m_size - sizeof(header) - fieldBytes) / m_stride;
+}
+
+ReplaySource::~ReplaySource()
+{
+	if (m_data == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+#else
+	munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+/**
+ * @return True if the capture was mapped and its header is valid.
+ */
+bool ReplaySource::valid() const
+{
+	return m_records != nullptr;
+}
+
+/**
+ * @return Input layout stored in the capture, or empty if none was stored.
+ */
+const std::vector<HidField>& ReplaySource::fields() const
+{
+	return m_fields;
+}
+
+/**
+ * @return Number of reports in the capture.
+ */
+size_t ReplaySource::count() const
+{
+	return m_count;
+}
+
+/**
+ * Restart from the first report.
+ */
+void ReplaySource::rewind()
+{
+	m_next = 0;
+}
+
+size_t ReplaySource::reportLength() const
+{
+	return m_reportLength;
+}
+
+/**
+ * Read the next report, waiting for its timestamp in real-time mode.
+ * @param report Destination buffer of reportLength bytes.
+ * @return True on success, false at the end of the capture.
+ */
+bool ReplaySource::read(uint8_t* report)
+{
+	if (m_next >= m_count)
+	{
+		return false;
+	}
+
+	if (m_realTime)
+	{
+		if (m_next == 0)
+		{
+			m_start = std::chrono::steady_clock::now();
+		}
+
+		std::this_thread::sleep_until(m_start + std::chrono::nanoseconds(timestamp(m_next)));
+	}
+
+	std::memcpy(report, m_records + m_next * m_stride + sizeof(uint64_t), m_reportLength);
+	++m_next;
+	return true;
+}
+
+/**
+ * Check if the next report can be read without waiting.
+ * @return True if a report is left and, in real-time mode, is already due.
+ */
+bool ReplaySource::ready() const
+{
+	if (m_next >= m_count)
+	{
+		return false;
+	}
+
+	return !m_realTime || m_next == 0 ||
+	       std::chrono::steady_clock::now() >= m_start + std::chrono::nanoseconds(timestamp(m_next));
+}
+
+/**
+ * In real time, skip the reports whose time has already passed.
+ */
+void ReplaySource::flush()
+{
+	if (!m_realTime || m_next == 0)
+	{
+		return;
+	}
+
+	const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+
+	while (m_next < m_count && timestamp(m_next) < elapsed)
+	{
+		++m_next;
+	}
+}
+
+uint64_t ReplaySource::timestamp(size_t index) const
+{
+	uint64_t result;
+	std::memcpy(&result, m_records + index * m_stride, sizeof(result));
+	return result;
+}
@@ -0,0 +1,56 @@
+/**
+ * triolinker-vjoy
+ * Report source replaying a capture file.
+ */
+
+#ifndef REPLAYSOURCE_HPP
+#define REPLAYSOURCE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DecodePlan.hpp"
+#include "ReportSource.hpp"
+
+/**
+ * Memory-maps a capture file and replays its reports, either with their
+ * original timing or as fast as they are read.
+ */
+class ReplaySource : public ReportSource
+{
+public:
+	ReplaySource(const std::string& path, bool realTime);
+	~ReplaySource() override;
+
+	ReplaySource(const ReplaySource&) = delete;
+	ReplaySource& operator=(const ReplaySource&) = delete;
+
+	bool valid() const;
+	const std::vector<HidField>& fields() const;
+	size_t count() const;
+	void rewind();
+
+	size_t reportLength() const override;
+	bool read(uint8_t* report) override;
+	bool ready() const override;
+	void flush() override;
+
+protected:
+	uint64_t timestamp(size_t index) const;
+
+	const uint8_t*        m_data         = nullptr;
+	size_t                m_size         = 0;
+	const uint8_t*        m_records      = nullptr;
+	size_t                m_reportLength = 0;
+	size_t                m_stride       = 0;
+	size_t                m_count        = 0;
+	size_t                m_next         = 0;
+	bool                  m_realTime;
+	std::vector<HidField> m_fields;
+
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#endif /* REPLAYSOURCE_HPP */
@@ -0,0 +1,263 @@
+/**
+ * triolinker-vjoy
+ * Input field layout from a raw HID report descriptor.
+ */
+
+#include <algorithm>
+#include <map>
+
+#include "ReportDescriptor.hpp"
+
+// Short item types.
+constexpr uint8_t ITEM_MAIN   = 0;
+constexpr uint8_t ITEM_GLOBAL = 1;
+constexpr uint8_t ITEM_LOCAL  = 2;
+
+// Main item tags.
+constexpr uint8_t MAIN_INPUT = 0x8;
+
+// Global item tags.
+constexpr uint8_t GLOBAL_USAGE_PAGE   = 0x0;
+constexpr uint8_t GLOBAL_LOGICAL_MIN  = 0x1;
+constexpr uint8_t GLOBAL_LOGICAL_MAX  = 0x2;
+constexpr uint8_t GLOBAL_REPORT_SIZE  = 0x7;
+constexpr uint8_t GLOBAL_REPORT_ID    = 0x8;
+constexpr uint8_t GLOBAL_REPORT_COUNT = 0x9;
+constexpr uint8_t GLOBAL_PUSH         = 0xA;
+constexpr uint8_t GLOBAL_POP          = 0xB;
+
+// Local item tags.
+constexpr uint8_t LOCAL_USAGE     = 0x0;
+constexpr uint8_t LOCAL_USAGE_MIN = 0x1;
+constexpr uint8_t LOCAL_USAGE_MAX = 0x2;
+
+// Input item flags.
+constexpr uint32_t INPUT_CONSTANT = 0x01;
+constexpr uint32_t INPUT_VARIABLE = 0x02;
+
+// Long item prefix.
+constexpr uint8_t ITEM_LONG = 0xFE;
+
+struct GlobalState
+{
+	uint16_t usagePage   = 0;
+	int32_t  logicalMin  = 0;
+	int32_t  logicalMax  = 0;
+	uint32_t reportSize  = 0;
+	uint32_t reportCount = 0;
+	uint8_t  reportId    = 0;
+};
+
+struct LocalState
+{
+	std::vector<uint32_t> usages; // extended usages (page << 16 | usage)
+	uint32_t usageMin = 0;
+	uint32_t usageMax = 0;
+	bool     range    = false;
+};
+
+/**
+ * Get the usage of a control in an input item.
+ * @param local Local state of the item.
+ * @param index Control index within the item.
+ * @return Extended usage, or 0 if the item has no usages.
+ */
+static uint32_t itemUsage(const LocalState& local, uint32_t index)
+{
+	if (local.range)
+	{
+		return std::min(local.usageMin + index, local.usageMax);
+	}
+
+	if (local.usages.empty())
+	{
+		return 0;
+	}
+
+	// Controls beyond the last usage share it.
+	return local.usages[std::min<size_t>(index, local.usages.size() - 1)];
+}
+
+/**
+ * Get the position and range of every variable input of a device.
+ * Bit offsets follow the Windows convention of a leading report ID byte,
+ * which is present (as 0) even if the device doesn't use report IDs.
+ * @param data Report descriptor.
+ * @param size Size of the report descriptor in bytes.
+ * @return Input report layout. Array inputs, such as keyboard key codes, are left out.
+ */
+ReportLayout parseReportDescriptor(const uint8_t* data, size_t size)
+{
+	ReportLayout result;
+
+	GlobalState              global;
+	LocalState               local;
+	std::vector<GlobalState> stack;
+
+	// Bit length of each input report by report ID, starting after the ID byte.
+	std::map<uint8_t, uint32_t> reportBits;
+
+	size_t i = 0;
+
+	while (i < size)
+	{
+		const uint8_t prefix = data[i++];
+
+		if (prefix == ITEM_LONG)
+		{
+			if (i >= size)
+			{
+				break;
+			}
+
+			i += 2 + data[i];
+			continue;
+		}
+
+		const size_t  length = (prefix & 3) == 3 ? 4 : (prefix & 3);
+		const uint8_t type   = (prefix >> 2) & 3;
+		const uint8_t tag    = prefix >> 4;
+
+		if (i + length > size)
+		{
+			break;
+		}
+
+		uint32_t value = 0;
+
+		for (size_t b = 0; b < length; b++)
+		{
+			value |= static_cast<uint32_t>(data[i + b]) << (b * 8);
+		}
+
+		// Sign-extended value for items that may be negative.
+		int32_t signedValue = static_cast<int32_t>(value);
+
+		if (length == 1)
+		{
+			signedValue = static_cast<int8_t>(value);
+		}
+		else if (length == 2)
+		{
+			signedValue = static_cast<int16_t>(value);
+		}
+
+		i += length;
+
+		// Usages without a page take the current usage page.
+		const uint32_t usage = length == 4 ? value : (static_cast<uint32_t>(global.usagePage) << 16) | value;
+
+		switch (type)
+		{
+			case ITEM_MAIN:
+			{
+				if (tag == MAIN_INPUT)
+				{
+					uint32_t& bits = reportBits[global.reportId];
+
+					for (uint32_t n = 0; n < global.reportCount; n++, bits += global.reportSize)
+					{
+						if ((value & INPUT_CONSTANT) || !(value & INPUT_VARIABLE) || global.reportSize == 0 || global.reportSize > 32)
+						{
+							continue;
+						}
+
+						const uint32_t fieldUsage = itemUsage(local, n);
+						const uint32_t offset     = bits + 8;
+
+						if (fieldUsage == 0 || offset > 0xFFFF)
+						{
+							continue;
+						}
+
+						HidField field;
+						field.usagePage  = static_cast<uint16_t>(fieldUsage >> 16);
+						field.usage      = static_cast<uint16_t>(fieldUsage);
+						field.reportId   = global.reportId;
+						field.bitOffset  = static_cast<uint16_t>(offset);
+						field.bitSize    = static_cast<uint8_t>(global.reportSize);
+						field.logicalMin = global.logicalMin;
+						field.logicalMax = global.logicalMax;
+
+						// Descriptors commonly give an unsigned maximum that only looks negative.
+						if (field.logicalMax < field.logicalMin && field.bitSize < 32)
+						{
+							field.logicalMax = static_cast<int32_t>(static_cast<uint32_t>(field.logicalMax) & ((1u << field.bitSize) - 1));
+						}
+
+						result.fields.push_back(field);
+					}
+				}
+
+				local = LocalState {};
+				break;
+			}
+
+			case ITEM_GLOBAL:
+				switch (tag)
+				{
+					case GLOBAL_USAGE_PAGE:
+						global.usagePage = static_cast<uint16_t>(value);
+						break;
+					case GLOBAL_LOGICAL_MIN:
+						global.logicalMin = signedValue;
+						break;
+					case GLOBAL_LOGICAL_MAX:
+						global.logicalMax = signedValue;
+						break;
+					case GLOBAL_REPORT_SIZE:
+						global.reportSize = value;
+						break;
+					case GLOBAL_REPORT_ID:
+						global.reportId = static_cast<uint8_t>(value);
+						result.reportIds = true;
+						break;
+					case GLOBAL_REPORT_COUNT:
+						global.reportCount = value;
+						break;
+					case GLOBAL_PUSH:
+						stack.push_back(global);
+						break;
+					case GLOBAL_POP:
+						if (!stack.empty())
+						{
+							global = stack.back();
+							stack.pop_back();
+						}
+						break;
+					default:
+						break;
+				}
+				break;
+
+			case ITEM_LOCAL:
+				switch (tag)
+				{
+					case LOCAL_USAGE:
+						local.usages.push_back(usage);
+						break;
+					case LOCAL_USAGE_MIN:
+						local.usageMin = usage;
+						local.range    = true;
+						break;
+					case LOCAL_USAGE_MAX:
+						local.usageMax = usage;
+						local.range    = true;
+						break;
+					default:
+						break;
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	for (const auto& [id, bits] : reportBits)
+	{
+		result.inputLength = std::max<size_t>(result.inputLength, 1 + (bits + 7) / 8);
+	}
+
+	return result;
+}
@@ -0,0 +1,27 @@
+/**
+ * triolinker-vjoy
+ * Input field layout from a raw HID report descriptor.
+ */
+
+#ifndef REPORTDESCRIPTOR_HPP
+#define REPORTDESCRIPTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DecodePlan.hpp"
+
+/**
+ * Input report layout of a device.
+ */
+struct ReportLayout
+{
+	std::vector<HidField> fields;
+	size_t                inputLength = 1;     // longest input report in bytes, including the report ID byte
+	bool                  reportIds   = false; // true if the device prefixes its reports with a report ID
+};
+
+ReportLayout parseReportDescriptor(const uint8_t* data, size_t size);
+
+#endif /* REPORTDESCRIPTOR_HPP */
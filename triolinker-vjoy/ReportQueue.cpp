@@ -0,0 +1,117 @@
+/**
+ * triolinker-vjoy
+ * Single-producer/single-consumer report queue.
+ */
+
+#include <cstring>
+
+#include "ReportQueue.hpp"
+
+/**
+ * @param capacity Number of reports the queue can hold. Rounded up to a power of two.
+ * @param reportLength Size of each report in bytes.
+ */
+ReportQueue::ReportQueue(size_t capacity, size_t reportLength)
+	: m_reportLength(reportLength)
+{
+	size_t size = 1;
+
+	while (size < capacity)
+	{
+		size <<= 1;
+	}
+
+	m_mask = size - 1;
+	m_storage.resize(size * reportLength);
+	m_timestamps.resize(size);
+}
+
+/**
+ * Append a report. Blocks while the queue is full.
+ * @param report Raw report of reportLength bytes.
+ * @param timestamp Value handed back by timestamp() along with the report.
+ */
+void ReportQueue::push(const uint8_t* report, uint64_t timestamp)
+{
+	const size_t head = m_head.load(std::memory_order_relaxed);
+	size_t tail = m_tail.load(std::memory_order_acquire);
+
+	while (head - tail > m_mask)
+	{
+		m_tail.wait(tail, std::memory_order_acquire);
+		tail = m_tail.load(std::memory_order_acquire);
+	}
+
+	memcpy(slot(head), report, m_reportLength);
+	m_timestamps[head & m_mask] = timestamp;
+
+	m_head.store(head + 1, std::memory_order_release);
+	m_head.notify_one();
+}
+
+/**
+ * Mark the end of the stream. The consumer drains what's left and then stops.
+ */
+void ReportQueue::close()
+{
+	m_head.fetch_or(CLOSED, std::memory_order_release);
+	m_head.notify_one();
+}
+
+/**
+ * Get the oldest queued report, blocking until one is available.
+ * The report stays valid until pop() is called.
+ * @return The report, or nullptr once the queue is closed and empty.
+ */
+const uint8_t* ReportQueue::wait()
+{
+	const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		const size_t head = m_head.load(std::memory_order_acquire);
+
+		if ((head & ~CLOSED) != tail)
+		{
+			return slot(tail);
+		}
+
+		if (head & CLOSED)
+		{
+			return nullptr;
+		}
+
+		m_head.wait(head, std::memory_order_acquire);
+	}
+}
+
+/**
+ * Get the timestamp pushed with the report returned by wait().
+ * @return Timestamp.
+ */
+uint64_t ReportQueue::timestamp() const
+{
+	return m_timestamps[m_tail.load(std::memory_order_relaxed) & m_mask];
+}
+
+/**
+ * Release the report returned by wait().
+ */
+void ReportQueue::pop()
+{
+	m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	m_tail.notify_one();
+}
+
+/**
+ * @return Number of queued reports.
+ */
+size_t ReportQueue::size() const
+{
+	return (m_head.load(std::memory_order_acquire) & ~CLOSED) - m_tail.load(std::memory_order_acquire);
+}
+
+uint8_t* ReportQueue::slot(size_t index)
+{
+	return &m_storage[(index & m_mask) * m_reportLength];
+}
@@ -0,0 +1,51 @@
+/**
+ * triolinker-vjoy
+ * Single-producer/single-consumer report queue.
+ */
+
+#ifndef REPORTQUEUE_HPP
+#define REPORTQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Lock-free ring of fixed-size raw reports shared by exactly one reader thread
+ * and one output thread. All storage is allocated up front.
+ */
+class ReportQueue
+{
+public:
+	ReportQueue(size_t capacity, size_t reportLength);
+
+	ReportQueue(const ReportQueue&) = delete;
+	ReportQueue& operator=(const ReportQueue&) = delete;
+
+	// Producer side.
+	void push(const uint8_t* report, uint64_t timestamp = 0);
+	void close();
+
+	// Consumer side.
+	const uint8_t* wait();
+	uint64_t timestamp() const;
+	void pop();
+
+	size_t size() const;
+
+protected:
+	static constexpr size_t CLOSED = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1);
+
+	uint8_t* slot(size_t index);
+
+	size_t                m_mask;
+	size_t                m_reportLength;
+	std::vector<uint8_t>  m_storage;
+	std::vector<uint64_t> m_timestamps;
+
+	alignas(64) std::atomic<size_t> m_head { 0 }; // next slot to write; CLOSED bit set by close()
+	alignas(64) std::atomic<size_t> m_tail { 0 }; // next slot to read
+};
+
+#endif /* REPORTQUEUE_HPP */
@@ -0,0 +1,70 @@
+/**
+ * triolinker-vjoy
+ * Raw input report source interface.
+ */
+
+#ifndef REPORTSOURCE_HPP
+#define REPORTSOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+using WaitHandle = void*; // file HANDLE opened for overlapped I/O
+constexpr WaitHandle INVALID_WAIT_HANDLE = nullptr;
+#else
+using WaitHandle = int;   // file descriptor
+constexpr WaitHandle INVALID_WAIT_HANDLE = -1;
+#endif
+
+/**
+ * Produces raw input reports, one at a time.
+ */
+class ReportSource
+{
+public:
+	virtual ~ReportSource() = default;
+
+	/**
+	 * @return Size of every report in bytes.
+	 */
+	virtual size_t reportLength() const = 0;
+
+	/**
+	 * Read the next report, blocking until one is available.
+	 * @param report Destination buffer of reportLength() bytes.
+	 * @return True on success, false once the source has failed or ended.
+	 */
+	virtual bool read(uint8_t* report) = 0;
+
+	/**
+	 * Check if the next report can be read without waiting.
+	 * @return True if read() would return immediately.
+	 */
+	virtual bool ready() const
+	{
+		return false;
+	}
+
+	/**
+	 * Discard every report that is already waiting to be read,
+	 * so the next read returns the first report to arrive after this call.
+	 */
+	virtual void flush()
+	{
+	}
+
+	/**
+	 * Get what to wait on for reports, so several sources can be waited on at once.
+	 * On Windows every read the source posts on this handle completes to the I/O
+	 * completion port the handle is associated with; once one has, ready() is true.
+	 * On Linux the descriptor is readable once read() would not block.
+	 * @return Handle to wait on, or INVALID_WAIT_HANDLE if the source has none.
+	 */
+	virtual WaitHandle waitHandle() const
+	{
+		return INVALID_WAIT_HANDLE;
+	}
+};
+
+#endif /* REPORTSOURCE_HPP */
@@ -0,0 +1,401 @@
+/**
+ * triolinker-vjoy
+ * Report source simulating a device at a fixed report rate.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "SimulatorSource.hpp"
+
+// Sleeping is only accurate to a millisecond or worse, so the last stretch before each report is spent spinning.
+constexpr std::chrono::microseconds SPIN_TIME(2000);
+
+/**
+ * Check valid() before use.
+ * @param mapping Mapping configuration the reports are laid out for.
+ * @param config Simulator settings.
+ */
+SimulatorSource::SimulatorSource(const MappingConfig& mapping, const SimulatorConfig& config)
+	: m_mapping(mapping),
+	  m_config(config),
+	  m_reportLength(layoutLength(mapping)),
+	  m_random(config.seed),
+	  m_period(1'000'000'000 / std::max(config.rate, 1u))
+{
+	m_config.burstSize = std::max(m_config.burstSize, 1u);
+	m_step.dpad = mapping.hat_center;
+
+	if (!config.script.empty())
+	{
+		m_valid = loadScript(config.script);
+	}
+}
+
+/**
+ * @return False if the script could not be read.
+ */
+bool SimulatorSource::valid() const
+{
+	return m_valid;
+}
+
+size_t SimulatorSource::reportLength() const
+{
+	return m_reportLength;
+}
+
+/**
+ * Wait for the next report's scheduled time and generate it.
+ * @param report Destination buffer of reportLength() bytes.
+ * @return True on success, false once the configured number of reports was generated.
+ */
+bool SimulatorSource::read(uint8_t* report)
+{
+	if (!m_valid || (m_config.reports != 0 && m_next >= m_config.reports))
+	{
+		return false;
+	}
+
+	if (m_next == 0)
+	{
+		m_start    = std::chrono::steady_clock::now();
+		m_deadline = deadline(0);
+	}
+
+	auto now = std::chrono::steady_clock::now();
+
+	if (now < m_deadline)
+	{
+		if (m_deadline - now > SPIN_TIME)
+		{
+			std::this_thread::sleep_until(m_deadline - SPIN_TIME);
+		}
+
+		while ((now = std::chrono::steady_clock::now()) < m_deadline)
+		{
+		}
+	}
+
+	m_lag    = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_deadline), std::chrono::nanoseconds(0));
+	m_maxLag = std::max(m_maxLag, m_lag);
+
+	// A report read within one period of its slot is on time; the reader only has to keep up on average.
+	if (m_lag > m_period)
+	{
+		++m_late;
+	}
+
+	if (m_script.empty())
+	{
+		randomStep();
+	}
+	else
+	{
+		if (m_repeat == 0)
+		{
+			m_step   = m_script[m_line];
+			m_repeat = m_step.repeat;
+			m_line   = (m_line + 1) % m_script.size();
+		}
+
+		--m_repeat;
+	}
+
+	write(report);
+
+	m_deadline = deadline(++m_next);
+	return true;
+}
+
+/**
+ * @return True if the next report is already due.
+ */
+bool SimulatorSource::ready() const
+{
+	return m_valid && m_next != 0 && (m_config.reports == 0 || m_next < m_config.reports) &&
+	       std::chrono::steady_clock::now() >= m_deadline;
+}
+
+/**
+ * Skip the reports that are already due. They are neither generated nor counted as late.
+ */
+void SimulatorSource::flush()
+{
+	if (m_next == 0)
+	{
+		return;
+	}
+
+	const auto now = std::chrono::steady_clock::now();
+
+	while (m_deadline < now && (m_config.reports == 0 || m_next < m_config.reports))
+	{
+		++m_flushed;
+		m_deadline = deadline(++m_next);
+	}
+}
+
+/**
+ * @return Number of reports generated so far.
+ */
+uint64_t SimulatorSource::generated() const
+{
+	return m_next - m_flushed;
+}
+
+/**
+ * @return Number of reports read more than one report period after they were due.
+ */
+uint64_t SimulatorSource::late() const
+{
+	return m_late;
+}
+
+/**
+ * @return Number of reports skipped by flush().
+ */
+uint64_t SimulatorSource::flushed() const
+{
+	return m_flushed;
+}
+
+/**
+ * @return Largest delay between a report being due and being read.
+ */
+std::chrono::nanoseconds SimulatorSource::maxLag() const
+{
+	return m_maxLag;
+}
+
+/**
+ * @return Delay between the last report being due and being read.
+ */
+std::chrono::nanoseconds SimulatorSource::lag() const
+{
+	return m_lag;
+}
+
+/**
+ * @param mapping Mapping configuration.
+ * @return Report length needed to hold every buffer in [Buffers], and at least 8 bytes.
+ */
+size_t SimulatorSource::layoutLength(const MappingConfig& mapping)
+{
+	const int buffers[] = {
+		mapping.buffer_x, mapping.buffer_y, mapping.buffer_z,
+		mapping.buffer_rx, mapping.buffer_ry, mapping.buffer_rz,
+		mapping.buffer_buttons1, mapping.buffer_buttons2, mapping.buffer_hat
+	};
+
+	return std::max<size_t>(8, static_cast<size_t>(*std::max_element(std::begin(buffers), std::end(buffers))) + 1);
+}
+
+/**
+ * Read a script. Each line sets any of the controls below, separated by spaces,
+ * and the resulting report is repeated `repeat` times. Controls not given keep
+ * their value from the previous line. The script loops.
+ * x, y, z, rx, ry, rz  Raw axis value (0-255).
+ * buttons              Button mask in hexadecimal; bit 0 is the lowest bit of Buttons1, bit 8 of Buttons2.
+ * dpad                 N, NE, E, SE, S, SW, W, NW or C.
+ * repeat               Number of reports (default 1).
+ * @param path Script file path.
+ * @return True if the script was read and contains at least one line.
+ */
+bool SimulatorSource::loadScript(const std::string& path)
+{
+	std::ifstream file(path);
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	static const char* const axisNames[AXIS_COUNT] = { "x", "y", "z", "rx", "ry", "rz" };
+
+	const std::pair<const char*, uint8_t> directions[] = {
+		{ "N",  m_mapping.hat_up },         { "NE", m_mapping.hat_up_right }, { "E",  m_mapping.hat_right },
+		{ "SE", m_mapping.hat_down_right }, { "S",  m_mapping.hat_down },     { "SW", m_mapping.hat_down_left },
+		{ "W",  m_mapping.hat_left },       { "NW", m_mapping.hat_up_left },  { "C",  m_mapping.hat_center }
+	};
+
+	Step        step = m_step;
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream words(line);
+		std::string        word;
+		bool               empty = true;
+
+		step.repeat = 1;
+
+		while (words >> word)
+		{
+			const size_t equals = word.find('=');
+
+			if (equals == std::string::npos)
+			{
+				return false;
+			}
+
+			const std::string key   = word.substr(0, equals);
+			const std::string value = word.substr(equals + 1);
+
+			try
+			{
+				const auto axis = std::find_if(std::begin(axisNames), std::end(axisNames), [&](const char* name) { return key == name; });
+
+				if (axis != std::end(axisNames))
+				{
+					step.axes[axis - std::begin(axisNames)] = static_cast<uint8_t>(std::stoul(value, nullptr, 0));
+				}
+				else if (key == "buttons")
+				{
+					step.buttons = static_cast<uint16_t>(std::stoul(value, nullptr, 16));
+				}
+				else if (key == "repeat")
+				{
+					step.repeat = std::max(static_cast<uint32_t>(std::stoul(value)), 1u);
+				}
+				else if (key == "dpad")
+				{
+					const auto direction = std::find_if(std::begin(directions), std::end(directions), [&](const auto& d) { return value == d.first; });
+
+					if (direction == std::end(directions))
+					{
+						return false;
+					}
+
+					step.dpad = direction->second;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			catch (const std::exception&)
+			{
+				return false;
+			}
+
+			empty = false;
+		}
+
+		if (!empty)
+		{
+			m_script.push_back(step);
+		}
+	}
+
+	return !m_script.empty();
+}
+
+/**
+ * Move the current controls a little: the sticks drift, and now and then
+ * a button is toggled or the D-Pad changes direction.
+ */
+void SimulatorSource::randomStep()
+{
+	std::uniform_int_distribution<int> drift(-4, 4);
+	std::uniform_int_distribution<int> event(0, 63);
+
+	for (auto& axis : m_step.axes)
+	{
+		axis = static_cast<uint8_t>(std::clamp(axis + drift(m_random), 0, 255));
+	}
+
+	if (event(m_random) == 0)
+	{
+		m_step.buttons ^= static_cast<uint16_t>(1 << std::uniform_int_distribution<int>(0, 15)(m_random));
+	}
+
+	// The D-Pad is mostly centered, since holding it locks the unlinked stick axes.
+	if (m_step.dpad != m_mapping.hat_center)
+	{
+		if (event(m_random) < 4)
+		{
+			m_step.dpad = m_mapping.hat_center;
+		}
+	}
+	else if (event(m_random) == 0)
+	{
+		const uint8_t directions[] = {
+			m_mapping.hat_up, m_mapping.hat_up_right, m_mapping.hat_right, m_mapping.hat_down_right,
+			m_mapping.hat_down, m_mapping.hat_down_left, m_mapping.hat_left, m_mapping.hat_up_left
+		};
+
+		m_step.dpad = directions[std::uniform_int_distribution<size_t>(0, std::size(directions) - 1)(m_random)];
+	}
+}
+
+/**
+ * Lay out the current controls in a report.
+ * Buffer 0 is the report ID and is left at 0, so controls assigned to it are not written.
+ * @param report Destination buffer of reportLength() bytes.
+ */
+void SimulatorSource::write(uint8_t* report) const
+{
+	std::memset(report, 0, m_reportLength);
+
+	const int axisBuffers[AXIS_COUNT] = {
+		m_mapping.buffer_x,  m_mapping.buffer_y,  m_mapping.buffer_z,
+		m_mapping.buffer_rx, m_mapping.buffer_ry, m_mapping.buffer_rz
+	};
+
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		if (axisBuffers[i] != 0)
+		{
+			report[axisBuffers[i]] = m_step.axes[i];
+		}
+	}
+
+	// Bits used by any D-Pad value belong to the D-Pad, not to buttons sharing its buffer.
+	const uint8_t hatMask = m_mapping.hat_up | m_mapping.hat_up_right | m_mapping.hat_right | m_mapping.hat_down_right |
+	                        m_mapping.hat_down | m_mapping.hat_down_left | m_mapping.hat_left | m_mapping.hat_up_left |
+	                        m_mapping.hat_center;
+
+	const int     buttonBuffers[2] = { m_mapping.buffer_buttons1, m_mapping.buffer_buttons2 };
+	const uint8_t buttonBytes[2]   = { static_cast<uint8_t>(m_step.buttons), static_cast<uint8_t>(m_step.buttons >> 8) };
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		if (buttonBuffers[i] != 0)
+		{
+			report[buttonBuffers[i]] |= buttonBuffers[i] == m_mapping.buffer_hat ? buttonBytes[i] & ~hatMask : buttonBytes[i];
+		}
+	}
+
+	if (m_mapping.buffer_hat != 0)
+	{
+		report[m_mapping.buffer_hat] = static_cast<uint8_t>((report[m_mapping.buffer_hat] & ~hatMask) | m_step.dpad);
+	}
+}
+
+/**
+ * @param index Report index.
+ * @return Time the report is due, according to the rate and profile.
+ */
+std::chrono::steady_clock::time_point SimulatorSource::deadline(uint64_t index)
+{
+	switch (m_config.profile)
+	{
+		case SimulatorProfile::Jitter:
+		{
+			const auto jitter = static_cast<int64_t>(m_config.jitter) * 1000;
+			return m_start + m_period * static_cast<int64_t>(index) + std::chrono::nanoseconds(std::uniform_int_distribution<int64_t>(-jitter, jitter)(m_random));
+		}
+
+		case SimulatorProfile::Burst:
+			return m_start + m_period * static_cast<int64_t>(index - index % m_config.burstSize);
+
+		default:
+			return m_start + m_period * static_cast<int64_t>(index);
+	}
+}
@@ -0,0 +1,105 @@
+/**
+ * triolinker-vjoy
+ * Report source simulating a device at a fixed report rate.
+ */
+
+#ifndef SIMULATORSOURCE_HPP
+#define SIMULATORSOURCE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DecodePlan.hpp"
+#include "ReportSource.hpp"
+
+enum class SimulatorProfile
+{
+	Steady, // reports evenly spaced
+	Jitter, // each report moved randomly within +/- jitter of its slot
+	Burst,  // burstSize reports back to back, then a gap; same average rate
+};
+
+/**
+ * Simulator settings, as read from the [Simulator] section of config.ini.
+ */
+struct SimulatorConfig
+{
+	uint32_t         rate      = 1000; // reports per second
+	SimulatorProfile profile   = SimulatorProfile::Steady;
+	uint32_t         jitter    = 100;  // microseconds
+	uint32_t         burstSize = 8;
+	uint64_t         reports   = 0;    // reports to generate, or 0 to run until stopped
+	std::string      script;           // script file, or empty for random input
+	uint32_t         seed      = 1;
+};
+
+/**
+ * Generates reports laid out per [Buffers] and [DPad] on a schedule, either
+ * from a script or as random stick, button and D-Pad movement.
+ * If the reader falls behind the schedule, reports are not dropped: read()
+ * returns immediately until it has caught up, like a device whose reports
+ * pile up in the driver's buffer. How far behind it fell is recorded.
+ */
+class SimulatorSource : public ReportSource
+{
+public:
+	SimulatorSource(const MappingConfig& mapping, const SimulatorConfig& config);
+
+	bool valid() const;
+
+	size_t reportLength() const override;
+	bool read(uint8_t* report) override;
+	bool ready() const override;
+	void flush() override;
+
+	uint64_t generated() const;
+	uint64_t late() const;
+	uint64_t flushed() const;
+	std::chrono::nanoseconds maxLag() const;
+	std::chrono::nanoseconds lag() const;
+
+	static size_t layoutLength(const MappingConfig& mapping);
+
+protected:
+	/**
+	 * Controls for one or more reports, as given by a script line.
+	 */
+	struct Step
+	{
+		uint8_t  axes[AXIS_COUNT] { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 };
+		uint16_t buttons = 0;
+		uint8_t  dpad    = 0; // raw D-Pad value
+		uint32_t repeat  = 1;
+	};
+
+	bool loadScript(const std::string& path);
+	void randomStep();
+	void write(uint8_t* report) const;
+	std::chrono::steady_clock::time_point deadline(uint64_t index);
+
+	MappingConfig   m_mapping;
+	SimulatorConfig m_config;
+	size_t          m_reportLength;
+	bool            m_valid = true;
+
+	std::vector<Step> m_script;
+	size_t            m_line   = 0;
+	uint32_t          m_repeat = 0;
+	Step              m_step;
+	std::mt19937      m_random;
+
+	uint64_t                 m_next = 0;
+	uint64_t                 m_late = 0;
+	uint64_t                 m_flushed = 0;
+	std::chrono::nanoseconds m_period;
+	std::chrono::nanoseconds m_maxLag { 0 };
+	std::chrono::nanoseconds m_lag { 0 };
+
+	std::chrono::steady_clock::time_point m_start;
+	std::chrono::steady_clock::time_point m_deadline;
+};
+
+#endif /* SIMULATORSOURCE_HPP */
@@ -0,0 +1,237 @@
+/**
+ * triolinker-vjoy
+ * Live counters published through shared memory.
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Stats.hpp"
+
+static bool feederRunning(const std::string& name, uint32_t pid);
+
+/**
+ * Create or open a stats block.
+ * A block is never created over one whose feeder is still running, so two
+ * feeders can't wipe each other's counters; block() is nullptr instead.
+ * @param name Name of the shared memory object.
+ * @param create True to create and initialize the block (the feeder), false
+ * to open an existing one read-only (a monitor).
+ */
+SharedStats::SharedStats(const std::string& name, bool create)
+	: m_name(name),
+	  m_owner(create)
+{
+	void* memory = nullptr;
+
+#ifdef _WIN32
+	const std::string path = "Local\\" + name;
+
+	m_handle = create
+		? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(StatsBlock), path.c_str())
+		: OpenFileMappingA(FILE_MAP_READ, FALSE, path.c_str());
+
+	if (m_handle == nullptr)
+	{
+		return;
+	}
+
+	// The mapping outlives its feeder only while a monitor has it open, so an existing one is in use.
+	if (create && GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		CloseHandle(m_handle);
+		m_handle = nullptr;
+		return;
+	}
+
+	memory = MapViewOfFile(m_handle, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, sizeof(StatsBlock));
+#else
+	const std::string path = "/" + name;
+	int fd = create ? shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644) : shm_open(path.c_str(), O_RDONLY, 0);
+
+	// A feeder that crashed leaves its block behind; only that one may be replaced.
+	if (fd < 0 && create && errno == EEXIST)
+	{
+		const SharedStats existing(name, false);
+
+		if (existing.block() != nullptr && feederRunning(name, existing.block()->pid))
+		{
+			m_owner = false;
+			return;
+		}
+
+		shm_unlink(path.c_str());
+		fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	}
+
+	if (fd < 0)
+	{
+		m_owner = false;
+		return;
+	}
+
+	// A block still being created is empty, and touching it would fault.
+	struct stat info {};
+	const bool sized = create ? ftruncate(fd, sizeof(StatsBlock)) == 0
+	                          : fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(StatsBlock));
+
+	if (sized)
+	{
+		memory = mmap(nullptr, sizeof(StatsBlock), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+		if (memory == MAP_FAILED)
+		{
+			memory = nullptr;
+		}
+	}
+
+	close(fd);
+#endif
+
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	if (create)
+	{
+		m_block = new (memory) StatsBlock;
+
+#ifdef _WIN32
+		m_block->pid = GetCurrentProcessId();
+#else
+		m_block->pid = static_cast<uint32_t>(getpid());
+#endif
+	}
+	else
+	{
+		m_block = static_cast<StatsBlock*>(memory);
+	}
+}
+
+SharedStats::~SharedStats()
+{
+#ifdef _WIN32
+	if (m_block != nullptr)
+	{
+		UnmapViewOfFile(m_block);
+	}
+
+	if (m_handle != nullptr)
+	{
+		CloseHandle(m_handle);
+	}
+#else
+	if (m_block != nullptr)
+	{
+		munmap(m_block, sizeof(StatsBlock));
+	}
+
+	if (m_owner)
+	{
+		shm_unlink(("/" + m_name).c_str());
+	}
+#endif
+}
+
+/**
+ * @return The block, or nullptr if it couldn't be created or opened.
+ */
+StatsBlock* SharedStats::block() const
+{
+	return m_block;
+}
+
+/**
+ * Check if the feeder that published a stats block is still running.
+ * @param name Name of the shared memory object.
+ * @param pid Process ID stored in the block.
+ * @return True if the process is alive and, on Linux, still owns the name.
+ */
+static bool feederRunning(const std::string& name, uint32_t pid)
+{
+#ifdef _WIN32
+	const HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+
+	if (process == nullptr)
+	{
+		return false;
+	}
+
+	const bool running = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+	CloseHandle(process);
+	return running;
+#else
+	// The feeder unlinks the name on exit; the PID check catches crashes.
+	const int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	close(fd);
+	return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+/**
+ * Print a running feeder's counters once per second until it exits.
+ * @param name Name of the shared memory object.
+ * @return 0 once the feeder exits, or -1 if no compatible feeder is running.
+ */
+int monitorStats(const std::string& name)
+{
+	const SharedStats stats(name, false);
+	const StatsBlock* block = stats.block();
+
+	if (block == nullptr || block->magic != STATS_MAGIC || block->version != STATS_VERSION || block->size < sizeof(StatsBlock))
+	{
+		std::cout << "No running feeder found." << std::endl;
+		return -1;
+	}
+
+	std::cout << "Feeder process " << block->pid << "." << std::endl;
+
+	uint64_t lastRead = block->reportsRead.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+
+		if (!feederRunning(name, block->pid))
+		{
+			std::cout << "Feeder exited." << std::endl;
+			return 0;
+		}
+
+		const uint64_t read = block->reportsRead.load(std::memory_order_relaxed);
+
+		std::cout << "read " << std::setw(10) << read
+		          << " (" << std::setw(5) << read - lastRead << "/s)"
+		          << "  mapped " << std::setw(10) << block->reportsMapped.load(std::memory_order_relaxed)
+		          << "  coalesced " << std::setw(8) << block->reportsCoalesced.load(std::memory_order_relaxed)
+		          << "  output " << std::setw(10) << block->outputCalls.load(std::memory_order_relaxed)
+		          << "  errors " << block->readErrors.load(std::memory_order_relaxed)
+		          << "  queue " << block->queueDepth.load(std::memory_order_relaxed)
+		          << "/" << block->queuePeak.load(std::memory_order_relaxed) << std::endl;
+
+		lastRead = read;
+	}
+}
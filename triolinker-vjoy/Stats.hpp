@@ -0,0 +1,87 @@
+/**
+ * triolinker-vjoy
+ * Live counters published through shared memory.
+ */
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+constexpr uint32_t STATS_MAGIC   = 0x5453'4C54; // "TLST"
+constexpr uint32_t STATS_VERSION = 1;
+constexpr auto     STATS_NAME    = "triolinker-vjoy-stats";
+
+/**
+ * Counters shared with external monitors. Readers must check magic and
+ * version, and may rely on size to skip counters added by later versions.
+ * Every counter has a single writer and is only ever increased with a plain
+ * relaxed store, so updating them costs the feeder no locked instructions.
+ * The exception is several feeders on an event loop with more than one
+ * worker, which count into the same block with atomic adds instead.
+ */
+struct StatsBlock
+{
+	uint32_t magic   = STATS_MAGIC;
+	uint32_t version = STATS_VERSION;
+	uint32_t size    = sizeof(StatsBlock);
+	uint32_t pid     = 0;
+
+	// Written by the reader.
+	alignas(64) std::atomic<uint64_t> reportsRead { 0 };
+	std::atomic<uint64_t> readErrors { 0 };
+	std::atomic<uint64_t> queueDepth { 0 }; // threaded mode only, as of the last push
+	std::atomic<uint64_t> queuePeak  { 0 };
+
+	// Written by the output, on its own cache line so the two threads don't contend.
+	alignas(64) std::atomic<uint64_t> reportsMapped { 0 };
+	std::atomic<uint64_t> reportsCoalesced { 0 };
+	std::atomic<uint64_t> outputCalls      { 0 };
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock-free");
+
+/**
+ * Increment a counter owned by the calling thread.
+ * @param counter Counter to increment.
+ */
+inline void bump(std::atomic<uint64_t>& counter)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/**
+ * Increment a counter other threads may be incrementing at the same time.
+ * @param counter Counter to increment.
+ */
+inline void add(std::atomic<uint64_t>& counter)
+{
+	counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Named shared memory holding a StatsBlock.
+ */
+class SharedStats
+{
+public:
+	SharedStats(const std::string& name, bool create);
+	~SharedStats();
+
+	SharedStats(const SharedStats&) = delete;
+	SharedStats& operator=(const SharedStats&) = delete;
+
+	StatsBlock* block() const;
+
+protected:
+	std::string m_name;
+	bool        m_owner;
+	StatsBlock* m_block  = nullptr;
+	void*       m_handle = nullptr; // Windows mapping handle
+};
+
+int monitorStats(const std::string& name);
+
+#endif /* STATS_HPP */
@@ -0,0 +1,53 @@
+/**
+ * triolinker-vjoy
+ * Thread scheduling options.
+ */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "Thread.hpp"
+
+/**
+ * Apply scheduling options to the calling thread.
+ * @param options Scheduling options.
+ */
+void configureThread(const ThreadOptions& options)
+{
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), options.priority);
+
+	if (options.affinity != 0)
+	{
+		SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(options.affinity));
+	}
+#else
+	if (options.priority > 0)
+	{
+		sched_param param {};
+		param.sched_priority = options.priority;
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	}
+
+	if (options.affinity != 0)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+
+		for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++)
+		{
+			if (options.affinity & (static_cast<uint64_t>(1) << cpu))
+			{
+				CPU_SET(cpu, &set);
+			}
+		}
+
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#endif
+}
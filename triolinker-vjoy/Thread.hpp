@@ -0,0 +1,19 @@
+/**
+ * triolinker-vjoy
+ * Thread scheduling options.
+ */
+
+#ifndef THREAD_HPP
+#define THREAD_HPP
+
+#include <cstdint>
+
+struct ThreadOptions
+{
+	int      priority = 0; // Windows: THREAD_PRIORITY_*; Linux: SCHED_FIFO priority if above 0
+	uint64_t affinity = 0; // processor mask, or 0 to leave unchanged
+};
+
+void configureThread(const ThreadOptions& options);
+
+#endif /* THREAD_HPP */
@@ -0,0 +1,159 @@
+/**
+ * triolinker-vjoy
+ * Linux uinput virtual gamepad output.
+ */
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "UinputOutput.hpp"
+
+static constexpr uint16_t axisCodes[AXIS_COUNT] = { ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ };
+
+// Hat axis values for each 45 degree POV step, starting at north.
+static constexpr int32_t hatX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static constexpr int32_t hatY[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+/**
+ * @param fd uinput device from openUinput(), or any writable file to record
+ * the raw input_event stream instead. Owned by the output.
+ * @param device True if fd is a uinput device that must be destroyed on close.
+ */
+UinputOutput::UinputOutput(int fd, bool device)
+	: m_fd(fd),
+	  m_device(device)
+{
+}
+
+UinputOutput::~UinputOutput()
+{
+	if (m_device)
+	{
+		ioctl(m_fd, UI_DEV_DESTROY);
+	}
+
+	close(m_fd);
+}
+
+/**
+ * Send a state to the device. Nothing is written if no control changed.
+ * @param state Decoded state.
+ */
+void UinputOutput::commit(const JoyState& state)
+{
+	m_count = 0;
+
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		if (!m_valid || state.axes[i] != m_last.axes[i])
+		{
+			push(EV_ABS, axisCodes[i], state.axes[i]);
+		}
+	}
+
+	const uint32_t changed = m_valid ? state.buttons ^ m_last.buttons : ~0u;
+
+	for (size_t i = 0; i < BUTTON_COUNT; i++)
+	{
+		if (changed & (1u << i))
+		{
+			push(EV_KEY, static_cast<uint16_t>(BTN_TRIGGER_HAPPY1 + i), !!(state.buttons & (1u << i)));
+		}
+	}
+
+	if (!m_valid || state.pov != m_last.pov)
+	{
+		const size_t step = state.pov < 0 ? 0 : ((state.pov + 2250) / 4500) % 8;
+		const bool   held = state.pov >= 0;
+
+		push(EV_ABS, ABS_HAT0X, held ? hatX[step] : 0);
+		push(EV_ABS, ABS_HAT0Y, held ? hatY[step] : 0);
+	}
+
+	m_last  = state;
+	m_valid = true;
+
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	push(EV_SYN, SYN_REPORT, 0);
+
+	called();
+
+	// A failed write leaves the device with the previous state; the next change resends it.
+	if (write(m_fd, m_events.data(), m_count * sizeof(input_event)) < 0)
+	{
+		m_valid = false;
+	}
+}
+
+void UinputOutput::push(uint16_t type, uint16_t code, int32_t value)
+{
+	input_event& event = m_events[m_count++];
+	event.type  = type;
+	event.code  = code;
+	event.value = value;
+}
+
+/**
+ * Create a uinput gamepad with six axes, a hat and BUTTON_COUNT buttons.
+ * Axes use the default OutputSink range.
+ * @param name Device name shown to applications.
+ * @return uinput descriptor, or -1 on failure.
+ */
+int openUinput(const std::string& name)
+{
+	const int fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	bool success = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 && ioctl(fd, UI_SET_EVBIT, EV_ABS) == 0;
+
+	for (size_t i = 0; success && i < BUTTON_COUNT; i++)
+	{
+		success = ioctl(fd, UI_SET_KEYBIT, BTN_TRIGGER_HAPPY1 + i) == 0;
+	}
+
+	const AxisRange range;
+
+	for (size_t i = 0; success && i < AXIS_COUNT + 2; i++)
+	{
+		uinput_abs_setup abs {};
+
+		if (i < AXIS_COUNT)
+		{
+			abs.code = axisCodes[i];
+			abs.absinfo.minimum = range.min;
+			abs.absinfo.maximum = range.max;
+		}
+		else
+		{
+			abs.code = i == AXIS_COUNT ? ABS_HAT0X : ABS_HAT0Y;
+			abs.absinfo.minimum = -1;
+			abs.absinfo.maximum = 1;
+		}
+
+		success = ioctl(fd, UI_SET_ABSBIT, abs.code) == 0 && ioctl(fd, UI_ABS_SETUP, &abs) == 0;
+	}
+
+	uinput_setup setup {};
+	setup.id.bustype = BUS_VIRTUAL;
+	std::strncpy(setup.name, name.c_str(), UINPUT_MAX_NAME_SIZE - 1);
+
+	if (!success || ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
@@ -0,0 +1,47 @@
+/**
+ * triolinker-vjoy
+ * Linux uinput virtual gamepad output.
+ */
+
+#ifndef UINPUTOUTPUT_HPP
+#define UINPUTOUTPUT_HPP
+
+#include <array>
+#include <string>
+
+#include <linux/input.h>
+
+#include "OutputSink.hpp"
+
+/**
+ * Pushes decoded states to a uinput device as evdev events.
+ * All changed controls of one state are written with a single write() call,
+ * terminated by one SYN_REPORT.
+ */
+class UinputOutput : public OutputSink
+{
+public:
+	UinputOutput(int fd, bool device);
+	~UinputOutput() override;
+
+	UinputOutput(const UinputOutput&) = delete;
+	UinputOutput& operator=(const UinputOutput&) = delete;
+
+	void commit(const JoyState& state) override;
+
+protected:
+	void push(uint16_t type, uint16_t code, int32_t value);
+
+	int      m_fd;
+	bool     m_device;
+	JoyState m_last;
+	bool     m_valid = false;
+
+	// Every axis, every button, both hat axes and SYN_REPORT.
+	std::array<input_event, AXIS_COUNT + BUTTON_COUNT + 3> m_events {};
+	size_t m_count = 0;
+};
+
+int openUinput(const std::string& name);
+
+#endif /* UINPUTOUTPUT_HPP */
@@ -0,0 +1,150 @@
+/**
+ * triolinker-vjoy
+ * vJoy output through vGen.
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "VJoyOutput.hpp"
+
+static LONG JOYSTICK_POSITION_V2::* const axisFields[AXIS_COUNT] = {
+	&JOYSTICK_POSITION_V2::wAxisX,
+	&JOYSTICK_POSITION_V2::wAxisY,
+	&JOYSTICK_POSITION_V2::wAxisZ,
+	&JOYSTICK_POSITION_V2::wAxisXRot,
+	&JOYSTICK_POSITION_V2::wAxisYRot,
+	&JOYSTICK_POSITION_V2::wAxisZRot,
+};
+
+/**
+ * @param pov Angle in 1/100 degrees, or -1 for centered.
+ * @return Direction of a discrete POV: 0 (north) to 3 (west), or -1 for centered.
+ * Diagonals round clockwise, since a discrete POV can't show them.
+ */
+static int discreteDirection(int32_t pov)
+{
+	return pov < 0 ? -1 : ((pov + 4500) / 9000) % 4;
+}
+
+VJoyOutput::VJoyOutput(HDEVICE hDev, OutputMode mode)
+	: m_hDev(hDev),
+	  m_mode(mode)
+{
+	GetDevId(m_hDev, &m_id);
+	m_position.bDevice = static_cast<BYTE>(m_id);
+	m_discretePov      = GetVJDContPovNumber(m_id) == 0 && GetVJDDiscPovNumber(m_id) > 0;
+
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		const UINT usage = HID_USAGE_X + static_cast<UINT>(i);
+		LONG min, max;
+
+		// Axes that aren't configured keep vJoy's default logical range.
+		if (GetVJDAxisMin(m_id, usage, &min) && GetVJDAxisMax(m_id, usage, &max))
+		{
+			m_axisRanges[i].min = min;
+			m_axisRanges[i].max = max;
+		}
+	}
+}
+
+/**
+ * Get the logical range of an axis, queried from the driver at startup.
+ * @param axis Axis index (0-based).
+ * @return Logical range.
+ */
+AxisRange VJoyOutput::axisRange(size_t axis) const
+{
+	return m_axisRanges[axis];
+}
+
+/**
+ * Send a state to the device.
+ * @param state Decoded state.
+ */
+void VJoyOutput::commit(const JoyState& state)
+{
+	if (m_mode == OutputMode::Frame)
+	{
+		commitFrame(state);
+	}
+	else
+	{
+		commitDelta(state);
+	}
+
+	m_last  = state;
+	m_valid = true;
+}
+
+void VJoyOutput::commitDelta(const JoyState& state)
+{
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		if (!m_valid || state.axes[i] != m_last.axes[i])
+		{
+			SetAxis(state.axes[i], m_id, HID_USAGE_X + static_cast<UINT>(i));
+			called();
+		}
+	}
+
+	const uint32_t changed = m_valid ? state.buttons ^ m_last.buttons : ~0u;
+
+	for (size_t i = 0; i < BUTTON_COUNT; i++)
+	{
+		if (changed & (1u << i))
+		{
+			SetBtn(!!(state.buttons & (1u << i)), m_id, static_cast<UCHAR>(i + 1));
+			called();
+		}
+	}
+
+	if (m_discretePov)
+	{
+		const int direction = discreteDirection(state.pov);
+
+		if (!m_valid || direction != discreteDirection(m_last.pov))
+		{
+			SetDiscPov(direction, m_id, 1);
+			called();
+		}
+	}
+	else if (!m_valid || state.pov != m_last.pov)
+	{
+		SetContPov(static_cast<DWORD>(state.pov), m_id, 1);
+		called();
+	}
+}
+
+void VJoyOutput::commitFrame(const JoyState& state)
+{
+	if (m_valid &&
+	    std::equal(std::begin(state.axes), std::end(state.axes), std::begin(m_last.axes)) &&
+	    state.buttons == m_last.buttons &&
+	    state.pov == m_last.pov)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < AXIS_COUNT; i++)
+	{
+		m_position.*axisFields[i] = state.axes[i];
+	}
+
+	m_position.lButtons = static_cast<LONG>(state.buttons);
+
+	// Discrete POVs take a nibble each, 0xF when centered; only the first one is used.
+	if (m_discretePov)
+	{
+		const int direction = discreteDirection(state.pov);
+		m_position.bHats    = direction < 0 ? 0xFFFFFFFF : 0xFFFFFFF0 | static_cast<DWORD>(direction);
+	}
+	else
+	{
+		m_position.bHats = static_cast<DWORD>(state.pov);
+	}
+
+	UpdateVJD(m_id, &m_position);
+	called();
+}
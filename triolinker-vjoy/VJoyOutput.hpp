@@ -0,0 +1,41 @@
+/**
+ * triolinker-vjoy
+ * vJoy output through vGen.
+ */
+
+#ifndef VJOYOUTPUT_HPP
+#define VJOYOUTPUT_HPP
+
+#include "vGen.hpp"
+#include "Config.hpp"
+#include "OutputSink.hpp"
+
+/**
+ * Pushes decoded states to a vJoy device.
+ * Only controls that differ from the last committed state are sent to the driver.
+ */
+class VJoyOutput : public OutputSink
+{
+public:
+	VJoyOutput(HDEVICE hDev, OutputMode mode);
+
+	AxisRange axisRange(size_t axis) const override;
+
+	void commit(const JoyState& state) override;
+
+protected:
+	void commitDelta(const JoyState& state);
+	void commitFrame(const JoyState& state);
+
+	HDEVICE    m_hDev;
+	UINT       m_id = 0;
+	OutputMode m_mode;
+	JoyState   m_last;
+	bool       m_valid       = false;
+	bool       m_discretePov = false; // the device has a 4-direction POV instead of a continuous one
+
+	JOYSTICK_POSITION_V2 m_position {};
+	AxisRange            m_axisRanges[AXIS_COUNT];
+};
+
+#endif /* VJOYOUTPUT_HPP */
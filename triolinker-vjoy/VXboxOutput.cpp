@@ -0,0 +1,99 @@
+/**
+ * triolinker-vjoy
+ * Virtual Xbox controller output through vGen.
+ */
+
+#include "VXboxOutput.hpp"
+
+static DWORD (__cdecl* const stickSetters[XBOX_STICK_COUNT])(UINT, SHORT) = {
+	SetAxisLx, SetAxisLy, SetAxisRx, SetAxisRy
+};
+
+static DWORD (__cdecl* const triggerSetters[2])(UINT, BYTE) = {
+	SetTriggerL, SetTriggerR
+};
+
+VXboxOutput::VXboxOutput(HDEVICE hDev, const XboxMapping& mapping)
+	: m_hDev(hDev),
+	  m_mapping(mapping)
+{
+	// The vXbox functions take the controller's user index.
+	GetDevId(m_hDev, &m_index);
+}
+
+/**
+ * @param axis Axis index (0-based).
+ * @return The full signed 16-bit range, so stick values need no scaling.
+ */
+AxisRange VXboxOutput::axisRange(size_t /*axis*/) const
+{
+	return { -32768, 32767 };
+}
+
+/**
+ * Send a state to the device.
+ * @param state Decoded state.
+ */
+void VXboxOutput::commit(const JoyState& state)
+{
+	send(toXbox(m_mapping, state));
+}
+
+/**
+ * Center the sticks and release the triggers and buttons.
+ */
+void VXboxOutput::reset()
+{
+	send(XboxState());
+}
+
+/**
+ * Send the controls that differ from the last state sent.
+ * @param xbox Controller state.
+ */
+void VXboxOutput::send(const XboxState& xbox)
+{
+	if (m_valid && xbox == m_last)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < XBOX_STICK_COUNT; i++)
+	{
+		if (!m_valid || xbox.sticks[i] != m_last.sticks[i])
+		{
+			stickSetters[i](m_index, xbox.sticks[i]);
+			called();
+		}
+	}
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		if (!m_valid || xbox.triggers[i] != m_last.triggers[i])
+		{
+			triggerSetters[i](m_index, xbox.triggers[i]);
+			called();
+		}
+	}
+
+	const uint16_t changed = m_valid ? xbox.buttons ^ m_last.buttons : 0xFFFF;
+
+	// All four directions go out in one call.
+	if (changed & XBOX_DPAD)
+	{
+		SetDpad(m_index, static_cast<UCHAR>(xbox.buttons & XBOX_DPAD));
+		called();
+	}
+
+	for (const uint16_t button : XBOX_BUTTONS)
+	{
+		if (changed & button)
+		{
+			SetButton(m_index, button, !!(xbox.buttons & button));
+			called();
+		}
+	}
+
+	m_last  = xbox;
+	m_valid = true;
+}
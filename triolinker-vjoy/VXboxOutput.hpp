@@ -0,0 +1,38 @@
+/**
+ * triolinker-vjoy
+ * Virtual Xbox controller output through vGen.
+ */
+
+#ifndef VXBOXOUTPUT_HPP
+#define VXBOXOUTPUT_HPP
+
+#include "vGen.hpp"
+#include "OutputSink.hpp"
+#include "XboxMapping.hpp"
+
+/**
+ * Pushes decoded states to a vXbox device.
+ * Each report is converted to a complete controller state first, and only
+ * the controls that differ from the last committed state are sent.
+ */
+class VXboxOutput : public OutputSink
+{
+public:
+	VXboxOutput(HDEVICE hDev, const XboxMapping& mapping);
+
+	AxisRange axisRange(size_t axis) const override;
+
+	void commit(const JoyState& state) override;
+	void reset() override;
+
+protected:
+	void send(const XboxState& xbox);
+
+	HDEVICE     m_hDev;
+	UINT        m_index = 0;
+	XboxMapping m_mapping;
+	XboxState   m_last;
+	bool        m_valid = false;
+};
+
+#endif /* VXBOXOUTPUT_HPP */
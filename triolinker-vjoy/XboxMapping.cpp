@@ -0,0 +1,94 @@
+/**
+ * triolinker-vjoy
+ * Mapping of decoded controls to a virtual Xbox controller.
+ */
+
+#include <algorithm>
+
+#include "XboxMapping.hpp"
+
+// In the order of XboxMapping::buttons.
+const uint16_t XBOX_BUTTONS[XBOX_BUTTON_COUNT] = {
+	XBOX_A, XBOX_B, XBOX_X, XBOX_Y, XBOX_LB, XBOX_RB, XBOX_BACK, XBOX_START, XBOX_LTHUMB, XBOX_RTHUMB
+};
+
+static bool pressed(const JoyState& state, int8_t button)
+{
+	return button >= 0 && (state.buttons & (1u << button));
+}
+
+/**
+ * @param state Decoded state.
+ * @param source Stick or trigger source.
+ * @return Value between -32768 and 32767.
+ */
+static int32_t sourceValue(const JoyState& state, const XboxSource& source)
+{
+	if (pressed(state, source.button))
+	{
+		return 32767;
+	}
+
+	if (source.axis < 0)
+	{
+		return -32768;
+	}
+
+	const int32_t value = std::clamp(state.axes[source.axis], -32768, 32767);
+	return source.invert ? -1 - value : value;
+}
+
+/**
+ * Convert a decoded state to an Xbox controller state.
+ * @param mapping Xbox mapping.
+ * @param state Decoded state, with axes between -32768 and 32767.
+ * @return Xbox controller state.
+ */
+XboxState toXbox(const XboxMapping& mapping, const JoyState& state)
+{
+	XboxState result;
+
+	for (size_t i = 0; i < XBOX_STICK_COUNT; i++)
+	{
+		const XboxSource& source = mapping.sticks[i];
+
+		// Unmapped sticks rest in the center rather than at the minimum.
+		if (source.axis >= 0 || source.button >= 0)
+		{
+			result.sticks[i] = static_cast<int16_t>(sourceValue(state, source));
+		}
+	}
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		result.triggers[i] = static_cast<uint8_t>((sourceValue(state, mapping.triggers[i]) + 32768) >> 8);
+	}
+
+	for (size_t i = 0; i < XBOX_BUTTON_COUNT; i++)
+	{
+		if (pressed(state, mapping.buttons[i]))
+		{
+			result.buttons |= XBOX_BUTTONS[i];
+		}
+	}
+
+	if (state.pov >= 0)
+	{
+		if (state.pov > 27000 || state.pov < 9000)  result.buttons |= XBOX_DPAD_UP;
+		if (state.pov > 0 && state.pov < 18000)     result.buttons |= XBOX_DPAD_RIGHT;
+		if (state.pov > 9000 && state.pov < 27000)  result.buttons |= XBOX_DPAD_DOWN;
+		if (state.pov > 18000)                      result.buttons |= XBOX_DPAD_LEFT;
+	}
+
+	const uint16_t directions[4] = { XBOX_DPAD_UP, XBOX_DPAD_DOWN, XBOX_DPAD_LEFT, XBOX_DPAD_RIGHT };
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		if (pressed(state, mapping.dpad[i]))
+		{
+			result.buttons |= directions[i];
+		}
+	}
+
+	return result;
+}
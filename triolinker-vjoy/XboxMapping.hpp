@@ -0,0 +1,78 @@
+/**
+ * triolinker-vjoy
+ * Mapping of decoded controls to a virtual Xbox controller.
+ */
+
+#ifndef XBOXMAPPING_HPP
+#define XBOXMAPPING_HPP
+
+#include <cstdint>
+
+#include "DecodePlan.hpp"
+
+// XInput button bits, as in XINPUT_GAMEPAD::wButtons.
+constexpr uint16_t XBOX_DPAD_UP    = 0x0001;
+constexpr uint16_t XBOX_DPAD_DOWN  = 0x0002;
+constexpr uint16_t XBOX_DPAD_LEFT  = 0x0004;
+constexpr uint16_t XBOX_DPAD_RIGHT = 0x0008;
+constexpr uint16_t XBOX_DPAD       = 0x000F;
+constexpr uint16_t XBOX_START      = 0x0010;
+constexpr uint16_t XBOX_BACK       = 0x0020;
+constexpr uint16_t XBOX_LTHUMB     = 0x0040;
+constexpr uint16_t XBOX_RTHUMB     = 0x0080;
+constexpr uint16_t XBOX_LB         = 0x0100;
+constexpr uint16_t XBOX_RB         = 0x0200;
+constexpr uint16_t XBOX_A          = 0x1000;
+constexpr uint16_t XBOX_B          = 0x2000;
+constexpr uint16_t XBOX_X          = 0x4000;
+constexpr uint16_t XBOX_Y          = 0x8000;
+
+constexpr size_t XBOX_BUTTON_COUNT = 10;
+constexpr size_t XBOX_STICK_COUNT  = 4; // LX, LY, RX, RY
+
+/**
+ * Where an Xbox stick or trigger takes its value from.
+ */
+struct XboxSource
+{
+	int8_t axis   = -1;    // decoded axis index, or -1
+	bool   invert = false;
+	int8_t button = -1;    // decoded button index, or -1; fully pressed while held
+};
+
+/**
+ * Xbox controller mapping, as read from the [vXbox] section of config.ini.
+ * Decoded axes are expected in the range -32768 to 32767.
+ */
+struct XboxMapping
+{
+	// LX=X, LY=-Y, RX=RX, RY=-RY: XInput's Y axes point up.
+	XboxSource sticks[XBOX_STICK_COUNT] { { 0, false }, { 1, true }, { 3, false }, { 4, true } };
+
+	// LT=Z, RT=RZ
+	XboxSource triggers[2] { { 2, false }, { 5, false } };
+
+	// Decoded button index for A, B, X, Y, LB, RB, Back, Start, LThumb and RThumb, or -1.
+	int8_t buttons[XBOX_BUTTON_COUNT] { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+	// Decoded button index for D-Pad up, down, left and right, or -1. Combined with the POV.
+	int8_t dpad[4] { -1, -1, -1, -1 };
+};
+
+/**
+ * State of a virtual Xbox controller, laid out like XINPUT_GAMEPAD.
+ */
+struct XboxState
+{
+	uint16_t buttons = 0;
+	uint8_t  triggers[2] {};
+	int16_t  sticks[XBOX_STICK_COUNT] {};
+
+	bool operator==(const XboxState&) const = default;
+};
+
+extern const uint16_t XBOX_BUTTONS[XBOX_BUTTON_COUNT];
+
+XboxState toXbox(const XboxMapping& mapping, const JoyState& state);
+
+#endif /* XBOXMAPPING_HPP */
@@ -1,38 +1,37 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cwchar>
+#include <cwctype>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
-#include <Xinput.h>
 #include <hidsdi.h>
 #include <SetupAPI.h>
 
-#include <vGenInterface.h>
-
+#include "vGen.hpp"
 #include "IniFile.hpp"
-
-static int vendorID = 0x7701;
-static int productID = 0x0003;
-static int buffer_x = 3;
-static int buffer_y = 4;
-static int buffer_z = 0;
-static int buffer_rx = 0;
-static int buffer_ry = 0;
-static int buffer_rz = 0;
-static int buffer_buttons1 = 1;
-static int buffer_buttons2 = 2;
-static int buffer_hat = 2;
-static uint8_t hat_up = 0x10;
-static uint8_t hat_up_right = 0x30;
-static uint8_t hat_up_left = 0x90;
-static uint8_t hat_down = 0x40;
-static uint8_t hat_down_right = 0x60;
-static uint8_t hat_down_left = 0xC0;
-static uint8_t hat_left = 0x80;
-static uint8_t hat_right = 0x20;
-static uint8_t hat_center = 0;
-static bool dPadAsButtons = false;
+#include "Capture.hpp"
+#include "Config.hpp"
+#include "DecodePlan.hpp"
+#include "DeviceWatcher.hpp"
+#include "EventLoop.hpp"
+#include "Feeder.hpp"
+#include "HidCaps.hpp"
+#include "HidReader.hpp"
+#include "ParallelProbe.hpp"
+#include "ReplaySource.hpp"
+#include "SimulatorSource.hpp"
+#include "Stats.hpp"
+#include "VJoyOutput.hpp"
+#include "VXboxOutput.hpp"
 
 struct Handle
 {
@@ -68,178 +67,510 @@ struct Handle
 	}
 };
 
-HANDLE findTrio();
-
-enum ButtonBits : uint8_t
+/**
+ * Everything belonging to one configured device.
+ */
+struct Device
 {
-	Button0 = 0x01,
-	Button1 = 0x02,
-	Button2 = 0x04,
-	Button3 = 0x08,
-	Button4 = 0x10,
-	Button5 = 0x20,
-	Button6 = 0x40,
-	Button7 = 0x80,
+	DeviceConfig                     config;
+	HDEVICE                          hDev = INVALID_DEV;
+	std::unique_ptr<OutputSink>      output;
+	Handle                           handle { nullptr };
+	std::unique_ptr<HidReader>       reader;
+	std::wstring                     path;     // lowercase device path while connected, empty while disconnected
+	std::wstring                     lastPath; // where the device was last found, tried first when looking for it
+	std::vector<HidField>            fields;
+	std::unique_ptr<RecordingSource> recorder;
+	ReportSource*                    source = nullptr;
+	std::unique_ptr<DecodePlan>      plan;
+	std::unique_ptr<Feeder>          feeder;
 };
 
-bool CheckIfButtonIsPad(int buffer, uint8_t button)
+std::wstring lowercase(std::wstring text);
+HANDLE openDevice(const std::wstring& path, const DeviceConfig& config, const std::vector<std::wstring>& exclude, DWORD flags);
+HANDLE openFirst(const std::vector<std::wstring>& paths, const DeviceConfig& config, const std::vector<std::wstring>& exclude, std::wstring& path, DWORD flags);
+HANDLE findDevice(ProbePool& probes, const DeviceConfig& config, const std::vector<std::wstring>& exclude, std::wstring& path, DWORD flags);
+std::vector<std::wstring> discoverDevices(ProbePool& probes, const std::vector<DeviceConfig>& configs, const std::vector<std::wstring>& exclude, bool all);
+
+// Where each device was last found, so the next start can open it without going through every HID device.
+constexpr char CACHE_FILE[] = "cache.ini";
+
+// HID devices are checked a few at a time, and one that doesn't answer in time is skipped.
+// At most PROBE_THREADS are ever started, including those left waiting on devices that didn't answer.
+constexpr size_t                    PROBE_WORKERS = 4;
+constexpr size_t                    PROBE_THREADS = 8;
+constexpr std::chrono::milliseconds PROBE_TIMEOUT(500);
+
+/**
+ * Start reading from an opened device.
+ * @param device Device to read; its recorder, if any, follows the new reader.
+ * @param handle Device handle, owned by the device from now on.
+ * @param path Device path.
+ * @param settings Feeder settings.
+ * @param readFields True to read the input field layout into the device's fields.
+ * @return 0 on success, or -3 or -4 if the device's capabilities could not be read.
+ */
+static int openReader(Device& device, HANDLE handle, const std::wstring& path, const FeederConfig& settings, bool readFields)
 {
-	if (buffer == buffer_hat && !dPadAsButtons)
+	// The old reader's reads must be finished before its handle is closed.
+	device.reader.reset();
+	device.handle = Handle(handle);
+
+	HIDP_CAPS caps {};
+	PHIDP_PREPARSED_DATA ptr = nullptr;
+
+	if (!HidD_GetPreparsedData(handle, &ptr))
 	{
-		if (hat_center & button || button == hat_up || button == hat_up_right || button == hat_right || button == hat_down_right || button == hat_down || button == hat_down_left || button == hat_left || button == hat_up_left || button == hat_center) return true;
+		std::cout << "HidD_GetPreparsedData failed." << std::endl;
+		return -3;
 	}
-	return false;
+
+	if (!HidP_GetCaps(ptr, &caps))
+	{
+		std::cout << "HidP_GetCaps failed." << std::endl;
+		HidD_FreePreparsedData(ptr);
+		return -4;
+	}
+
+	if (readFields)
+	{
+		device.fields = readInputFields(ptr, caps);
+	}
+
+	HidD_FreePreparsedData(ptr);
+
+	// Windows keeps 32 reports by default; after a long stall they are all stale.
+	if (settings.inputBuffers != 0 && !HidD_SetNumInputBuffers(handle, settings.inputBuffers))
+	{
+		std::cout << "HidD_SetNumInputBuffers failed." << std::endl;
+	}
+
+	// Reports queued before the feeder started describe input that's long gone.
+	HidD_FlushQueue(handle);
+
+	device.reader = std::make_unique<HidReader>(handle, caps.InputReportByteLength, settings.pendingReads);
+	device.path     = lowercase(path);
+	device.lastPath = device.path;
+
+	if (device.recorder)
+	{
+		device.recorder->attach(*device.reader);
+	}
+	else
+	{
+		device.source = device.reader.get();
+	}
+
+	return 0;
 }
 
 int main(int argc, char** argv)
 {
 	CopyFileA("default.ini", "config.ini", true);
 
-	const IniFile config("config.ini");
+	const CommandLine options = parseCommandLine(argc, argv);
 
-	const  bool hide          = config.getBool("General",  "HideWindow",    false);
-	const  bool unlinkDpad    = config.getBool("General",  "UnlinkDPad",    true);
-	const float defaultX      = config.getFloat("General", "DefaultX",      50.1f);
-	const float defaultY      = config.getFloat("General", "DefaultY",      50.1f);
-	dPadAsButtons = config.getBool("General", "DPadAsButtons", false);
-	vendorID = std::stol(config.getString("General", "VendorID", "7701"), nullptr, 16);
-	productID = std::stol(config.getString("General", "ProductID", "0003"), nullptr, 16);
-	buffer_x = config.getInt("Buffers", "X", 3);
-	buffer_y = config.getInt("Buffers", "Y", 4);
-	buffer_z = config.getInt("Buffers", "Z", 0);
-	buffer_rx = config.getInt("Buffers", "RX", 0);
-	buffer_ry = config.getInt("Buffers", "RY", 0);
-	buffer_rz = config.getInt("Buffers", "RZ", 0);
-	buffer_buttons1 = config.getInt("Buffers", "Buttons1", 1);
-	buffer_buttons2 = config.getInt("Buffers", "Buttons2", 2);
-	buffer_hat = config.getInt("Buffers", "DPad", 2);
-	hat_up = std::stol(config.getString("DPad", "DPad North", "0x10"), nullptr, 16);
-	hat_down = std::stol(config.getString("DPad", "DPad South", "0x40"), nullptr, 16);
-	hat_left = std::stol(config.getString("DPad", "DPad West", "0x80"), nullptr, 16);
-	hat_right = std::stol(config.getString("DPad", "DPad East", "0x20"), nullptr, 16);
-	hat_up_left = std::stol(config.getString("DPad", "DPad NorthWest", "0x90"), nullptr, 16);
-	hat_up_right = std::stol(config.getString("DPad", "DPad NorthEast", "0x30"), nullptr, 16);
-	hat_down_left = std::stol(config.getString("DPad", "DPad SouthWest", "0xC0"), nullptr, 16);
-	hat_down_right = std::stol(config.getString("DPad", "DPad SouthEast", "0x60"), nullptr, 16);
-	hat_center = std::stol(config.getString("DPad", "DPad Center", "0"), nullptr, 16);
+	FeederConfig settings = readConfig(IniFile("config.ini"));
 
-	const DevType devType = DevType::vJoy;
-
-	HDEVICE hDev;
-	const auto r = AcquireDev(1, devType, &hDev);
+	if (options.stats)
+	{
+		return monitorStats(options.statsName.empty() ? settings.statsName : options.statsName);
+	}
 
-	if (r != 0)
+	// Captures and simulations stand in for a single device.
+	if (!options.replay.empty() || options.simulate)
 	{
-		std::cout << "USB device not found." << std::endl;
-		return -1;
+		settings.devices.resize(1);
+		settings.reconnect = false;
 	}
 
-	const Handle trio(findTrio());
+	const bool several = settings.devices.size() > 1;
 
-	if (trio.handle == nullptr)
+	// Several devices share the event loop's workers, which wait for their overlapped reads to complete.
+	if (several)
 	{
-		std::cout << "Unable to detect device: vendor ID " << std::hex << vendorID << " product ID " << std::hex << productID << "." << std::endl;
-		return -2;
+		settings.feeder.threaded = false;
+		settings.pendingReads    = std::max(settings.pendingReads, 1);
 	}
 
-	std::cout << "Device found: vendor ID " << std::hex << vendorID << " product ID " << std::hex << productID << "." << std::endl;
+	const DWORD flags = settings.pendingReads > 0 ? FILE_FLAG_OVERLAPPED : 0;
 
-	HIDP_CAPS caps {};
-	PHIDP_PREPARSED_DATA ptr = nullptr;
+	// Outlives the devices and the watcher, which look for devices with it.
+	ProbePool probes(PROBE_THREADS);
+
+	std::vector<std::unique_ptr<Device>> devices;
+	std::mutex                           mutex; // guards the paths and readers of disconnected devices
+
+	std::unique_ptr<ReplaySource>    replay;
+	std::unique_ptr<SimulatorSource> simulator;
+	std::unique_ptr<CaptureWriter>   writer;
 
-	if (!HidD_GetPreparsedData(trio.handle, &ptr))
+	// Paths of the devices currently open, so no two sections open the same device.
+	const auto openPaths = [&devices]
 	{
-		std::cout << "HidD_GetPreparsedData failed." << std::endl;
-		return -3;
-	}
+		std::vector<std::wstring> paths;
 
-	if (!HidP_GetCaps(ptr, &caps))
+		for (const auto& device : devices)
+		{
+			if (!device->path.empty())
+			{
+				paths.push_back(device->path);
+			}
+		}
+
+		return paths;
+	};
+
+	IniFile cache(CACHE_FILE);
+	bool    cacheChanged = false;
+
+	std::optional<std::vector<std::wstring>> discovered;
+
+	for (const DeviceConfig& config : settings.devices)
 	{
-		std::cout << "HidP_GetCaps failed." << std::endl;
-		HidD_FreePreparsedData(ptr);
-		return -4;
+		auto& device  = *devices.emplace_back(std::make_unique<Device>());
+		device.config = config;
+
+		const std::string section = "Device" + std::to_string(devices.size());
+
+		if (!config.missingConfig.empty())
+		{
+			std::cout << "Unable to read device configuration " << config.missingConfig << "." << std::endl;
+			return -8;
+		}
+
+		const DevType devType = config.device == OutputDevice::VXbox ? DevType::vXbox : DevType::vJoy;
+
+		if (AcquireDev(config.id, devType, &device.hDev) != 0)
+		{
+			std::cout << "USB device not found." << std::endl;
+			return -1;
+		}
+
+		if (devType == DevType::vXbox)
+		{
+			device.output = std::make_unique<VXboxOutput>(device.hDev, config.xbox);
+		}
+		else
+		{
+			device.output = std::make_unique<VJoyOutput>(device.hDev, config.outputMode);
+		}
+
+		MappingConfig& mapping = device.config.mapping;
+
+		for (size_t i = 0; i < AXIS_COUNT; i++)
+		{
+			mapping.axisRanges[i] = device.output->axisRange(i);
+		}
+
+		if (!options.replay.empty())
+		{
+			replay = std::make_unique<ReplaySource>(options.replay, !options.fast);
+
+			if (!replay->valid())
+			{
+				std::cout << "Unable to read capture file " << options.replay << "." << std::endl;
+				return -5;
+			}
+
+			device.fields = replay->fields();
+			device.source = replay.get();
+		}
+		else if (options.simulate)
+		{
+			simulator = std::make_unique<SimulatorSource>(mapping, settings.simulator);
+
+			if (!simulator->valid())
+			{
+				std::cout << "Unable to read simulator script " << settings.simulator.script << "." << std::endl;
+				return -7;
+			}
+
+			// Simulated reports are laid out per [Buffers], so there is no descriptor.
+			device.config.descriptorLayout = false;
+			device.source = simulator.get();
+		}
+		else
+		{
+			std::wstring path   = cache.getWString(section, "Path");
+			HANDLE       handle = path.empty() ? nullptr : openDevice(path, config, openPaths(), flags);
+
+			// The HID devices are looked through once, for every section at the same time.
+			if (handle == nullptr)
+			{
+				if (!discovered)
+				{
+					discovered = discoverDevices(probes, settings.devices, {}, several);
+				}
+
+				handle = openFirst(*discovered, config, openPaths(), path, flags);
+			}
+
+			if (handle == nullptr)
+			{
+				std::cout << "Unable to detect device: vendor ID " << std::hex << config.vendorID << " product ID " << std::hex << config.productID << "." << std::endl;
+				return -2;
+			}
+
+			std::cout << "Device found: vendor ID " << std::hex << config.vendorID << " product ID " << std::hex << config.productID << "." << std::endl;
+
+			// Captures always store the layout, so they can be replayed with either layout.
+			if (const int result = openReader(device, handle, path, settings, device.config.descriptorLayout || !options.record.empty()); result != 0)
+			{
+				return result;
+			}
+
+			if (device.lastPath != lowercase(cache.getWString(section, "Path")))
+			{
+				cache.setWString(section, "Path", device.lastPath);
+				cacheChanged = true;
+			}
+		}
+
+		device.plan = device.config.descriptorLayout ? std::make_unique<DecodePlan>(mapping, device.fields) : std::make_unique<DecodePlan>(mapping);
+
+		// A capture or device whose reports end before a field the layout uses can't be decoded.
+		if (device.source->reportLength() < device.plan->reportLength())
+		{
+			std::cout << "Reports of " << std::dec << device.source->reportLength() << " bytes are too short for the configured layout, which reads " << device.plan->reportLength() << "." << std::endl;
+			return -9;
+		}
+
+		// Only the first device is recorded.
+		if (!options.record.empty() && devices.size() == 1)
+		{
+			writer = std::make_unique<CaptureWriter>(options.record, device.source->reportLength(), device.fields);
+
+			if (!writer->good())
+			{
+				std::cout << "Unable to create capture file " << options.record << "." << std::endl;
+				return -6;
+			}
+
+			device.recorder = std::make_unique<RecordingSource>(*device.source, *writer);
+			device.source   = device.recorder.get();
+		}
+
+		device.feeder = std::make_unique<Feeder>(*device.plan, *device.source, *device.output, settings.feeder);
 	}
 
-	HidD_FreePreparsedData(ptr);
+	if (cacheChanged)
+	{
+		cache.save(CACHE_FILE);
+	}
 
-	if (hide)
+	if (settings.hide)
 	{
 		ShowWindow(GetConsoleWindow(), SW_HIDE);
 	}
 
-	DWORD dummy;
-	std::vector<uint8_t> buffer(caps.InputReportByteLength);
+	EventLoop loop(settings.workers);
 
-	while (ReadFile(trio.handle, buffer.data(), static_cast<DWORD>(buffer.size()), &dummy, nullptr))
+	for (const auto& device : devices)
 	{
-		const uint8_t buttons1 = *reinterpret_cast<uint8_t*>(&buffer[buffer_buttons1]);
-		const uint8_t buttons2 = *reinterpret_cast<uint8_t*>(&buffer[buffer_buttons2]);
-		const uint8_t hat	   = *reinterpret_cast<uint8_t*>(&buffer[buffer_hat]);
+		loop.add(*device->source, *device->feeder);
+	}
 
-		const auto x = buffer[buffer_x];
-		const auto y = buffer[buffer_y];
-		const auto z = buffer[buffer_z];
-		const auto rx = buffer[buffer_rx];
-		const auto ry = buffer[buffer_ry];
-		const auto rz = buffer[buffer_rz];
-		if (unlinkDpad && hat != hat_center)
+	// Feeders on different workers count into the block at the same time.
+	const SharedStats stats(settings.statsName, true);
+
+	if (stats.block() == nullptr)
+	{
+		std::cout << "Counters are not published: " << settings.statsName << " is in use by another feeder. Set StatsName to tell them apart." << std::endl;
+	}
+
+	for (const auto& device : devices)
+	{
+		device->feeder->publish(stats.block(), several && loop.workers() > 1);
+	}
+
+	std::condition_variable reconnected;
+
+	// Reopen a disconnected device and resume feeding it, given the path of a device that just appeared,
+	// or an empty path to look through every HID device. Runs on the watcher's thread. The device is
+	// looked for without the mutex held, since that can take a while; it is only taken to swap in the handle.
+	const auto reconnect = [&](size_t index, const std::wstring& path)
+	{
+		Device&             device = *devices[index];
+		const DeviceConfig& config = device.config;
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if (!device.path.empty())
+		{
+			return false;
+		}
+
+		std::wstring                    found   = path.empty() ? device.lastPath : path;
+		const std::vector<std::wstring> exclude = openPaths();
+		lock.unlock();
+
+		const HANDLE handle = path.empty() ? findDevice(probes, config, exclude, found, flags) : openDevice(path, config, exclude, flags);
+
+		if (handle == nullptr)
+		{
+			return false;
+		}
+
+		lock.lock();
+
+		// Another arrival may have reopened this device, or given the same one to another device, meanwhile.
+		const std::vector<std::wstring> paths = openPaths();
+
+		if (!device.path.empty() || std::find(paths.begin(), paths.end(), lowercase(found)) != paths.end())
+		{
+			CloseHandle(handle);
+			return false;
+		}
+
+		// The layout was read when the device was first opened, and the decode plan still uses it.
+		if (openReader(device, handle, found, settings, false) != 0)
+		{
+			return false;
+		}
+
+		std::cout << "Device reconnected: vendor ID " << std::hex << config.vendorID << " product ID " << std::hex << config.productID << "." << std::endl;
+		device.feeder->attach(*device.source);
+
+		if (several)
 		{
-			SetDevAxis(hDev, 1, defaultX);
-			SetDevAxis(hDev, 2, defaultY);
+			loop.reattach(index, *device.source);
 		}
 		else
 		{
-			SetDevAxis(hDev, 1, 100.0f * (static_cast<float>(x) / 255.0f));
-			SetDevAxis(hDev, 2, 100.0f * (static_cast<float>(y) / 255.0f));
-		}
-		SetDevAxis(hDev, 3, 100.0f * (static_cast<float>(z) / 255.0f));
-		SetDevAxis(hDev, 4, 100.0f * (static_cast<float>(rx) / 255.0f));
-		SetDevAxis(hDev, 5, 100.0f * (static_cast<float>(ry) / 255.0f));
-		SetDevAxis(hDev, 6, 100.0f * (static_cast<float>(rz) / 255.0f));
-
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button0)) SetDevButton(hDev, 1, !!(buttons1 & Button0)); else SetDevButton(hDev, 1, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button1)) SetDevButton(hDev, 2, !!(buttons1 & Button1)); else SetDevButton(hDev, 2, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button2)) SetDevButton(hDev, 3, !!(buttons1 & Button2)); else SetDevButton(hDev, 3, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button3)) SetDevButton(hDev, 4, !!(buttons1 & Button3)); else SetDevButton(hDev, 4, 0);
-		
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button4)) SetDevButton(hDev, 5, !!(buttons1 & Button4)); else SetDevButton(hDev, 5, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button5)) SetDevButton(hDev, 6, !!(buttons1 & Button5)); else SetDevButton(hDev, 6, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button6)) SetDevButton(hDev, 7, !!(buttons1 & Button6)); else SetDevButton(hDev, 7, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons1, Button7)) SetDevButton(hDev, 8, !!(buttons1 & Button7)); else SetDevButton(hDev, 8, 0);
-		
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button0)) SetDevButton(hDev, 9,  !!(buttons2 & Button0)); else SetDevButton(hDev, 9, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button1)) SetDevButton(hDev, 10, !!(buttons2 & Button1)); else SetDevButton(hDev, 10, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button2)) SetDevButton(hDev, 11, !!(buttons2 & Button2)); else SetDevButton(hDev, 11, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button3)) SetDevButton(hDev, 12, !!(buttons2 & Button3)); else SetDevButton(hDev, 12, 0);
-
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button4)) SetDevButton(hDev, 13, !!(buttons2 & Button4)); else SetDevButton(hDev, 13, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button5)) SetDevButton(hDev, 14, !!(buttons2 & Button5)); else SetDevButton(hDev, 14, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button6)) SetDevButton(hDev, 15, !!(buttons2 & Button6)); else SetDevButton(hDev, 15, 0);
-		if (!CheckIfButtonIsPad(buffer_buttons2, Button7)) SetDevButton(hDev, 16, !!(buttons2 & Button7)); else SetDevButton(hDev, 16, 0);
-
-		if (!dPadAsButtons)
-		{
-			if (hat == hat_center) SetDevPov(hDev, 1, -1.0f);
-			else if (hat == hat_up) SetDevPov(hDev, 1, 0.0f);
-			else if (hat == hat_up_right) SetDevPov(hDev, 1, 45.0f);
-			else if (hat == hat_right) SetDevPov(hDev, 1, 90.0f);
-			else if (hat == hat_down_right) SetDevPov(hDev, 1, 135.0f);
-			else if (hat == hat_down) SetDevPov(hDev, 1, 180.0f);
-			else if (hat == hat_down_left) SetDevPov(hDev, 1, 225.0f);
-			else if (hat == hat_left) SetDevPov(hDev, 1, 270.0f);
-			else if (hat == hat_up_left) SetDevPov(hDev, 1, 315.0f);
-			else SetDevPov(hDev, 1, -1.0f);
-		}
-		else SetDevPov(hDev, 1, -1.0f);
-	}
-
-	if (hide)
+			reconnected.notify_all();
+		}
+
+		return true;
+	};
+
+	std::unique_ptr<DeviceWatcher> watcher;
+
+	// Bring the output of a device that went away to rest, and have the watcher reopen it if it is already back.
+	const auto disconnect = [&](size_t index)
+	{
+		Device& device = *devices[index];
+		device.feeder->reset();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::cout << "Device disconnected: vendor ID " << std::hex << device.config.vendorID << " product ID " << std::hex << device.config.productID << "." << std::endl;
+			device.path.clear();
+		}
+
+		// It may have been plugged back in before its removal was noticed. Looking through every
+		// HID device is left to the watcher's thread, so this worker goes back to feeding the others.
+		watcher->rescan();
+	};
+
+	if (settings.reconnect)
+	{
+		// Only disconnected devices are reopened, so only their section's IDs are tried.
+		// An arrival reopens one device, a rescan every one it can.
+		watcher = std::make_unique<DeviceWatcher>([&](const std::filesystem::path& path)
+		{
+			for (size_t i = 0; i < devices.size(); i++)
+			{
+				if (reconnect(i, path.wstring()) && !path.empty())
+				{
+					return;
+				}
+			}
+		});
+
+		if (!watcher->valid())
+		{
+			std::cout << "Unable to watch for devices; reconnecting is disabled." << std::endl;
+			watcher.reset();
+		}
+	}
+
+	if (settings.feeder.latency)
+	{
+		// Print the latency so far whenever Enter is pressed.
+		std::thread([&devices]
+		{
+			std::string line;
+
+			while (std::getline(std::cin, line))
+			{
+				for (const auto& device : devices)
+				{
+					device->feeder->latency().print(std::cout);
+				}
+			}
+		}).detach();
+	}
+
+	if (several)
+	{
+		if (watcher)
+		{
+			loop.onEnded(disconnect);
+		}
+
+		loop.run();
+	}
+	else
+	{
+		devices[0]->feeder->run();
+
+		while (watcher)
+		{
+			disconnect(0);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			reconnected.wait(lock, [&devices] { return !devices[0]->path.empty(); });
+			lock.unlock();
+
+			devices[0]->feeder->run();
+		}
+	}
+
+	if (settings.hide)
 	{
 		ShowWindow(GetConsoleWindow(), SW_SHOW);
 	}
 
-	std::cout << "Failed to read data from device." << std::endl;
-	RelinquishDev(hDev);
+	if (replay)
+	{
+		std::cout << "End of capture file." << std::endl;
+	}
+	else if (simulator)
+	{
+		std::cout << "Simulated reports: " << std::dec << simulator->generated() << ", late: " << simulator->late()
+		          << ", max lag: " << std::chrono::duration_cast<std::chrono::microseconds>(simulator->maxLag()).count() << " us" << std::endl;
+	}
+	else
+	{
+		std::cout << "Failed to read data from device." << std::endl;
+	}
+
+	for (const auto& device : devices)
+	{
+		if (several)
+		{
+			std::cout << "Device " << std::dec << device->config.id << ":" << std::endl;
+		}
+
+		if (settings.feeder.coalesce)
+		{
+			std::cout << "Coalesced reports: " << std::dec << device->feeder->coalesced() << std::endl;
+		}
+
+		if (settings.feeder.staleAfter != 0)
+		{
+			std::cout << "Flushed backlogs: " << std::dec << device->feeder->flushes() << std::endl;
+		}
+
+		if (settings.feeder.latency)
+		{
+			device->feeder->latency().print(std::cout);
+		}
+
+		RelinquishDev(device->hDev);
+	}
+
 	return 0;
 }
 
@@ -270,8 +601,211 @@ std::wstring getDevicePath(HDEVINFO handle, SP_DEVICE_INTERFACE_DATA* interface)
 	return result;
 }
 
-HANDLE findTrio()
+/**
+ * @param text Text to convert.
+ * @return Text in lowercase. Device paths are ASCII, and their case varies between APIs and drivers.
+ */
+std::wstring lowercase(std::wstring text)
+{
+	std::transform(text.begin(), text.end(), text.begin(), ::towlower);
+	return text;
+}
+
+/**
+ * Read a HID device's attributes through a handle without access rights, which opens even devices
+ * held exclusively by the system, such as keyboards, and never waits on a busy device.
+ * @param path Device path.
+ * @param attributes Receives the attributes.
+ * @return True on success.
+ */
+static bool readAttributes(const std::wstring& path, HIDD_ATTRIBUTES& attributes)
+{
+	const auto handle = CreateFile(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+
+	if (handle == nullptr || handle == reinterpret_cast<HANDLE>(-1))
+	{
+		return false;
+	}
+
+	const Handle guard(handle);
+
+	return HidD_GetAttributes(handle, &attributes);
+}
+
+/**
+ * @param path Lowercase device path.
+ * @param config Device settings: path filter.
+ * @return True if the path contains the device's path filter.
+ */
+static bool matchesPath(const std::wstring& path, const DeviceConfig& config)
+{
+	return path.find(lowercase(std::wstring(config.path.begin(), config.path.end()))) != std::wstring::npos;
+}
+
+/**
+ * Open a HID device if it matches a device's settings.
+ * @param path Device path.
+ * @param config Device settings: vendor ID, product ID and path filter.
+ * @param exclude Lowercase paths to skip, such as those of devices already opened.
+ * @param flags CreateFile flags.
+ * @return Device handle, or nullptr if the device doesn't match or could not be opened.
+ */
+HANDLE openDevice(const std::wstring& path, const DeviceConfig& config, const std::vector<std::wstring>& exclude, DWORD flags)
 {
+	const std::wstring lower = lowercase(path);
+
+	if (!matchesPath(lower, config) || std::find(exclude.begin(), exclude.end(), lower) != exclude.end())
+	{
+		return nullptr;
+	}
+
+	HIDD_ATTRIBUTES attributes {};
+	if (!readAttributes(path, attributes))
+	{
+		return nullptr;
+	}
+
+	if (attributes.VendorID != config.vendorID || attributes.ProductID != config.productID)
+	{
+		return nullptr;
+	}
+
+	const auto handle = CreateFile(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+	                               nullptr, OPEN_EXISTING, flags, nullptr);
+
+	if (handle == nullptr || handle == reinterpret_cast<HANDLE>(-1))
+	{
+		return nullptr;
+	}
+
+	return handle;
+}
+
+/**
+ * @param devInfoSet Device information set.
+ * @param info Device in the set.
+ * @return The device's hardware IDs in lowercase, as a list of null-terminated strings, or empty if they could not be read.
+ */
+static std::wstring readHardwareIDs(HDEVINFO devInfoSet, SP_DEVINFO_DATA* info)
+{
+	DWORD size = 0;
+	SetupDiGetDeviceRegistryProperty(devInfoSet, info, SPDRP_HARDWAREID, nullptr, nullptr, 0, &size);
+
+	if (size == 0)
+	{
+		return std::wstring();
+	}
+
+	std::vector<uint8_t> buffer(size);
+
+	if (!SetupDiGetDeviceRegistryProperty(devInfoSet, info, SPDRP_HARDWAREID, nullptr, buffer.data(), size, &size))
+	{
+		return std::wstring();
+	}
+
+	return lowercase(std::wstring(reinterpret_cast<const wchar_t*>(buffer.data()), size / sizeof(wchar_t)));
+}
+
+/**
+ * Check a device's hardware IDs against a device's settings, so devices of other makes are skipped without being opened.
+ * USB devices have IDs like HID\VID_045E&PID_028E, and Bluetooth devices like HID\{...}_VID&0002045E_PID&028E,
+ * where the four digits after VID& say where the vendor ID comes from.
+ * @param ids Hardware IDs, as returned by readHardwareIDs(). Searched as one string, since no ID spans two of them.
+ * @param config Device settings: vendor ID and product ID.
+ * @return False if the hardware IDs name another device; true if they match or are empty.
+ */
+static bool matchesHardwareID(const std::wstring& ids, const DeviceConfig& config)
+{
+	if (ids.empty())
+	{
+		return true;
+	}
+
+	wchar_t usb[32];
+	wchar_t bluetooth[32];
+	swprintf(usb, std::size(usb), L"vid_%04x&pid_%04x", config.vendorID, config.productID);
+	swprintf(bluetooth, std::size(bluetooth), L"%04x_pid&%04x", config.vendorID, config.productID);
+
+	if (ids.find(usb) != std::wstring::npos)
+	{
+		return true;
+	}
+
+	const size_t length = std::wcslen(bluetooth);
+
+	for (size_t i = ids.find(L"_vid&"); i != std::wstring::npos; i = ids.find(L"_vid&", i + 1))
+	{
+		if (i + 9 + length <= ids.size() && ids.compare(i + 9, length, bluetooth) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Open the first of several HID devices matching a device's settings.
+ * @param paths Device paths, in order of preference.
+ * @param config Device settings: vendor ID, product ID and path filter.
+ * @param exclude Lowercase paths to skip, such as those of devices already opened.
+ * @param path Receives the device path.
+ * @param flags CreateFile flags.
+ * @return Device handle, or nullptr if none of the devices could be opened.
+ */
+HANDLE openFirst(const std::vector<std::wstring>& paths, const DeviceConfig& config, const std::vector<std::wstring>& exclude, std::wstring& path, DWORD flags)
+{
+	for (const auto& candidate : paths)
+	{
+		if (const HANDLE handle = openDevice(candidate, config, exclude, flags); handle != nullptr)
+		{
+			path = candidate;
+			return handle;
+		}
+	}
+
+	return nullptr;
+}
+
+/**
+ * Find and open the first HID device matching a device's settings.
+ * The given path is tried first; only if it no longer leads to the device are the HID devices looked through.
+ * @param probes Threads reading the attributes of the HID devices looked through.
+ * @param config Device settings: vendor ID, product ID and path filter.
+ * @param exclude Lowercase paths to skip, such as those of devices already opened.
+ * @param path Path to try first, such as where the device was last found, or empty. Receives the device path.
+ * @param flags CreateFile flags.
+ * @return Device handle, or nullptr if no matching device could be opened.
+ */
+HANDLE findDevice(ProbePool& probes, const DeviceConfig& config, const std::vector<std::wstring>& exclude, std::wstring& path, DWORD flags)
+{
+	if (!path.empty())
+	{
+		if (const HANDLE handle = openDevice(path, config, exclude, flags); handle != nullptr)
+		{
+			return handle;
+		}
+	}
+
+	return openFirst(discoverDevices(probes, { config }, exclude, false), config, exclude, path, flags);
+}
+
+/**
+ * Look through the HID devices for those matching any of several devices' settings.
+ * Devices whose hardware IDs or paths don't match are skipped without being opened. The rest
+ * have their attributes read PROBE_WORKERS at a time, and any that take longer than
+ * PROBE_TIMEOUT are skipped, so a device that doesn't answer holds up nothing else.
+ * @param probes Threads reading the attributes.
+ * @param configs Device settings: vendor ID, product ID and path filter.
+ * @param exclude Lowercase paths to skip, such as those of devices already opened.
+ * @param all True to find every matching device, false to stop at the first one.
+ * @return Paths of the matching devices in enumeration order, however quickly each answered;
+ * with all false, only the first matching device in enumeration order.
+ */
+std::vector<std::wstring> discoverDevices(ProbePool& probes, const std::vector<DeviceConfig>& configs, const std::vector<std::wstring>& exclude, bool all)
+{
+	std::vector<std::wstring> candidates;
+
 	GUID guid {};
 	HidD_GetHidGuid(&guid);
 
@@ -279,7 +813,7 @@ HANDLE findTrio()
 
 	if (devInfoSet == reinterpret_cast<HDEVINFO>(-1))
 	{
-		return nullptr;
+		return candidates;
 	}
 
 	SP_DEVINFO_DATA info {};
@@ -287,38 +821,66 @@ HANDLE findTrio()
 
 	for (size_t i = 0; SetupDiEnumDeviceInfo(devInfoSet, static_cast<DWORD>(i), &info); i++)
 	{
+		const std::wstring               ids = readHardwareIDs(devInfoSet, &info);
+		std::vector<const DeviceConfig*> matching;
+
+		for (const auto& config : configs)
+		{
+			if (matchesHardwareID(ids, config))
+			{
+				matching.push_back(&config);
+			}
+		}
+
+		if (matching.empty())
+		{
+			continue;
+		}
+
 		SP_DEVICE_INTERFACE_DATA interfaceData {};
 		interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
 
 		for (size_t j = 0; SetupDiEnumDeviceInterfaces(devInfoSet, &info, &guid, static_cast<DWORD>(j), &interfaceData); j++)
 		{
-			std::wstring path(getDevicePath(devInfoSet, &interfaceData));
-
-			const auto handle = CreateFile(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
-			                               nullptr, OPEN_EXISTING, 0, nullptr);
+			std::wstring       candidate(getDevicePath(devInfoSet, &interfaceData));
+			const std::wstring lower = lowercase(candidate);
 
-			if (handle == nullptr || handle == reinterpret_cast<HANDLE>(-1))
+			if (std::find(exclude.begin(), exclude.end(), lower) == exclude.end() &&
+			    std::any_of(matching.begin(), matching.end(), [&](const DeviceConfig* config) { return matchesPath(lower, *config); }))
 			{
-				continue;
+				candidates.push_back(std::move(candidate));
 			}
+		}
+	}
 
-			Handle guard(handle);
+	SetupDiDestroyDeviceInfoList(devInfoSet);
 
-			HIDD_ATTRIBUTES attributes {};
-			if (!HidD_GetAttributes(handle, &attributes))
-			{
-				continue;
-			}
+	std::vector<std::pair<int, int>> ids;
 
-			if (attributes.VendorID != vendorID || attributes.ProductID != productID)
-			{
-				continue;
-			}
+	for (const auto& config : configs)
+	{
+		ids.emplace_back(config.vendorID, config.productID);
+	}
 
-			guard.handle = nullptr;
-			return handle;
+	// A probe that timed out may still be running after this returns, so it keeps its own copies.
+	const auto matches = probes.probe(candidates.size(), [candidates, ids](size_t index)
+	{
+		HIDD_ATTRIBUTES attributes {};
+
+		if (!readAttributes(candidates[index], attributes))
+		{
+			return false;
 		}
+
+		return std::find(ids.begin(), ids.end(), std::pair<int, int>(attributes.VendorID, attributes.ProductID)) != ids.end();
+	}, PROBE_WORKERS, PROBE_TIMEOUT, all);
+
+	std::vector<std::wstring> result;
+
+	for (const size_t index : matches)
+	{
+		result.push_back(candidates[index]);
 	}
 
-	return nullptr;
+	return result;
 }
@@ -0,0 +1,512 @@
+/**
+ * triolinker-vjoy
+ * Linux entry point: hidraw input, uinput output.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "IniFile.hpp"
+#include "Capture.hpp"
+#include "Config.hpp"
+#include "ConsoleOutput.hpp"
+#include "DecodePlan.hpp"
+#include "DeviceWatcher.hpp"
+#include "EventLoop.hpp"
+#include "Feeder.hpp"
+#include "HidrawReader.hpp"
+#include "ReplaySource.hpp"
+#include "ReportDescriptor.hpp"
+#include "SimulatorSource.hpp"
+#include "Stats.hpp"
+#include "UinputOutput.hpp"
+#include "VJoyOutput.hpp"
+#include "VXboxOutput.hpp"
+
+/**
+ * Everything belonging to one configured device.
+ */
+struct Device
+{
+	DeviceConfig                     config;
+	HDEVICE                          hDev = INVALID_DEV;
+	std::unique_ptr<OutputSink>      output;
+	std::unique_ptr<HidrawReader>    reader;
+	std::string                      path; // hidraw node while connected, empty while disconnected
+	ReportLayout                     layout;
+	std::unique_ptr<RecordingSource> recorder;
+	ReportSource*                    source = nullptr;
+	std::unique_ptr<DecodePlan>      plan;
+	std::unique_ptr<Feeder>          feeder;
+};
+
+/**
+ * Create the output of a device as configured in [Linux].
+ * @param settings Feeder settings.
+ * @param device Device to create the output for; receives the vGen handle if any.
+ * @param several True if more than one device is configured.
+ * @return False if the output could not be created.
+ */
+static bool createOutput(const FeederConfig& settings, Device& device, bool several)
+{
+	if (settings.output == "Console")
+	{
+		device.output = std::make_unique<ConsoleOutput>(std::cout);
+	}
+	else if (settings.output == "File")
+	{
+		// Each device gets its own file, named after its ID.
+		const std::string path = several ? settings.outputFile + "." + std::to_string(device.config.id) : settings.outputFile;
+		const int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+		if (file < 0)
+		{
+			std::cout << "Unable to create " << path << "." << std::endl;
+			return false;
+		}
+
+		device.output = std::make_unique<UinputOutput>(file, false);
+	}
+	else if (settings.output == "vGen")
+	{
+		const DevType devType = device.config.device == OutputDevice::VXbox ? DevType::vXbox : DevType::vJoy;
+
+		// Only the vGen mock exists outside Windows.
+		if (AcquireDev(device.config.id, devType, &device.hDev) != 0)
+		{
+			std::cout << "Unable to acquire vGen device " << device.config.id << "." << std::endl;
+			return false;
+		}
+
+		if (devType == DevType::vXbox)
+		{
+			device.output = std::make_unique<VXboxOutput>(device.hDev, device.config.xbox);
+		}
+		else
+		{
+			device.output = std::make_unique<VJoyOutput>(device.hDev, device.config.outputMode);
+		}
+	}
+	else
+	{
+		const int uinput = openUinput(settings.deviceName);
+
+		if (uinput < 0)
+		{
+			std::cout << "Unable to create uinput device." << std::endl;
+			return false;
+		}
+
+		device.output = std::make_unique<UinputOutput>(uinput, true);
+	}
+
+	return true;
+}
+
+/**
+ * Start reading from an opened hidraw device.
+ * @param device Device to read; its recorder, if any, follows the new reader.
+ * @param fd Non-blocking hidraw descriptor, owned by the reader from now on.
+ * @param path Device path.
+ * @return 0 on success, or -3 if the report descriptor could not be read.
+ */
+static int openReader(Device& device, int fd, const std::string& path)
+{
+	std::vector<uint8_t> descriptor;
+
+	if (!readReportDescriptor(fd, descriptor))
+	{
+		std::cout << "HIDIOCGRDESC failed." << std::endl;
+		close(fd);
+		return -3;
+	}
+
+	device.layout = parseReportDescriptor(descriptor.data(), descriptor.size());
+	device.reader = std::make_unique<HidrawReader>(fd, device.layout.inputLength, device.layout.reportIds);
+	device.path   = path;
+
+	// Reports queued before the feeder started describe input that's long gone.
+	device.reader->flush();
+
+	if (device.recorder)
+	{
+		device.recorder->attach(*device.reader);
+	}
+	else
+	{
+		device.source = device.reader.get();
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const CommandLine options = parseCommandLine(argc, argv);
+
+	FeederConfig settings = readConfig(IniFile("config.ini"));
+
+	if (options.stats)
+	{
+		return monitorStats(options.statsName.empty() ? settings.statsName : options.statsName);
+	}
+
+	// Captures and simulations stand in for a single device.
+	if (!options.replay.empty() || options.simulate)
+	{
+		settings.devices.resize(1);
+		settings.reconnect = false;
+	}
+
+	const bool several = settings.devices.size() > 1;
+
+	// Several devices share the event loop's workers.
+	if (several)
+	{
+		settings.feeder.threaded = false;
+	}
+
+	std::vector<std::unique_ptr<Device>> devices;
+	std::mutex                           mutex; // guards the paths and readers of disconnected devices
+
+	std::unique_ptr<ReplaySource>    replay;
+	std::unique_ptr<SimulatorSource> simulator;
+	std::unique_ptr<CaptureWriter>   writer;
+
+	// Paths of the devices currently open, so no two sections open the same device.
+	const auto openPaths = [&devices]
+	{
+		std::vector<std::string> paths;
+
+		for (const auto& device : devices)
+		{
+			if (!device->path.empty())
+			{
+				paths.push_back(device->path);
+			}
+		}
+
+		return paths;
+	};
+
+	for (const DeviceConfig& config : settings.devices)
+	{
+		auto& device  = *devices.emplace_back(std::make_unique<Device>());
+		device.config = config;
+
+		if (!config.missingConfig.empty())
+		{
+			std::cout << "Unable to read device configuration " << config.missingConfig << "." << std::endl;
+			return -8;
+		}
+
+		if (!createOutput(settings, device, several))
+		{
+			return -1;
+		}
+
+		MappingConfig& mapping = device.config.mapping;
+
+		for (size_t i = 0; i < AXIS_COUNT; i++)
+		{
+			mapping.axisRanges[i] = device.output->axisRange(i);
+		}
+
+		if (!options.replay.empty())
+		{
+			replay = std::make_unique<ReplaySource>(options.replay, !options.fast);
+
+			if (!replay->valid())
+			{
+				std::cout << "Unable to read capture file " << options.replay << "." << std::endl;
+				return -5;
+			}
+
+			device.layout.fields = replay->fields();
+			device.source = replay.get();
+		}
+		else if (options.simulate)
+		{
+			simulator = std::make_unique<SimulatorSource>(mapping, settings.simulator);
+
+			if (!simulator->valid())
+			{
+				std::cout << "Unable to read simulator script " << settings.simulator.script << "." << std::endl;
+				return -7;
+			}
+
+			// Simulated reports are laid out per [Buffers], so there is no descriptor.
+			device.config.descriptorLayout = false;
+			device.source = simulator.get();
+		}
+		else
+		{
+			std::string path;
+			const int fd = openHidraw(config.vendorID, config.productID, config.path, openPaths(), path);
+
+			if (fd < 0)
+			{
+				std::cout << "Unable to detect device: vendor ID " << std::hex << config.vendorID << " product ID " << std::hex << config.productID << "." << std::endl;
+				return -2;
+			}
+
+			std::cout << "Device found: vendor ID " << std::hex << config.vendorID << " product ID " << std::hex << config.productID << " (" << path << ")." << std::endl;
+
+			if (const int result = openReader(device, fd, path); result != 0)
+			{
+				return result;
+			}
+		}
+
+		device.plan = device.config.descriptorLayout ? std::make_unique<DecodePlan>(mapping, device.layout.fields) : std::make_unique<DecodePlan>(mapping);
+
+		// A capture or device whose reports end before a field the layout uses can't be decoded.
+		if (device.source->reportLength() < device.plan->reportLength())
+		{
+			std::cout << "Reports of " << std::dec << device.source->reportLength() << " bytes are too short for the configured layout, which reads " << device.plan->reportLength() << "." << std::endl;
+			return -9;
+		}
+
+		// Only the first device is recorded.
+		if (!options.record.empty() && devices.size() == 1)
+		{
+			writer = std::make_unique<CaptureWriter>(options.record, device.source->reportLength(), device.layout.fields);
+
+			if (!writer->good())
+			{
+				std::cout << "Unable to create capture file " << options.record << "." << std::endl;
+				return -6;
+			}
+
+			device.recorder = std::make_unique<RecordingSource>(*device.source, *writer);
+			device.source   = device.recorder.get();
+		}
+
+		device.feeder = std::make_unique<Feeder>(*device.plan, *device.source, *device.output, settings.feeder);
+	}
+
+	EventLoop loop(settings.workers);
+
+	for (const auto& device : devices)
+	{
+		loop.add(*device->source, *device->feeder);
+	}
+
+	// Feeders on different workers count into the block at the same time.
+	const SharedStats stats(settings.statsName, true);
+
+	if (stats.block() == nullptr)
+	{
+		std::cout << "Counters are not published: " << settings.statsName << " is in use by another feeder. Set StatsName to tell them apart." << std::endl;
+	}
+
+	for (const auto& device : devices)
+	{
+		device->feeder->publish(stats.block(), several && loop.workers() > 1);
+	}
+
+	std::condition_variable reconnected;
+
+	// Reopen a disconnected device and resume feeding it, given the path of a device that just appeared,
+	// or an empty path to look through every hidraw device. Runs on the watcher's thread. The device is
+	// looked for without the mutex held, since that can take a while; it is only taken to swap in the reader.
+	const auto reconnect = [&](size_t index, const std::string& path)
+	{
+		Device&             device = *devices[index];
+		const DeviceConfig& config = device.config;
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if (!device.path.empty())
+		{
+			return false;
+		}
+
+		const std::vector<std::string> exclude = openPaths();
+		lock.unlock();
+
+		std::string found = path;
+		int         fd    = -1;
+
+		if (path.empty())
+		{
+			fd = openHidraw(config.vendorID, config.productID, config.path, exclude, found);
+		}
+		else if (path.find(config.path) != std::string::npos && std::find(exclude.begin(), exclude.end(), path) == exclude.end())
+		{
+			fd = openHidrawPath(path, config.vendorID, config.productID);
+		}
+
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		lock.lock();
+
+		// Another arrival may have reopened this device, or given the same one to another device, meanwhile.
+		const std::vector<std::string> paths = openPaths();
+
+		if (!device.path.empty() || std::find(paths.begin(), paths.end(), found) != paths.end())
+		{
+			close(fd);
+			return false;
+		}
+
+		if (openReader(device, fd, found) != 0)
+		{
+			return false;
+		}
+
+		std::cout << "Device reconnected: vendor ID " << std::hex << config.vendorID << " product ID " << std::hex << config.productID << " (" << found << ")." << std::endl;
+		device.feeder->attach(*device.source);
+
+		if (several)
+		{
+			loop.reattach(index, *device.source);
+		}
+		else
+		{
+			reconnected.notify_all();
+		}
+
+		return true;
+	};
+
+	std::unique_ptr<DeviceWatcher> watcher;
+
+	// Bring the output of a device that went away to rest, and have the watcher reopen it if it is already back.
+	const auto disconnect = [&](size_t index)
+	{
+		Device& device = *devices[index];
+		device.feeder->reset();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::cout << "Device disconnected: " << device.path << "." << std::endl;
+			device.path.clear();
+		}
+
+		// It may have been plugged back in before its removal was noticed. Looking through every
+		// hidraw device is left to the watcher's thread, so this worker goes back to feeding the others.
+		watcher->rescan();
+	};
+
+	if (settings.reconnect)
+	{
+		// Only disconnected devices are reopened, so only their section's IDs are tried.
+		// An arrival reopens one device, a rescan every one it can.
+		watcher = std::make_unique<DeviceWatcher>([&](const std::filesystem::path& path)
+		{
+			for (size_t i = 0; i < devices.size(); i++)
+			{
+				if (reconnect(i, path.string()) && !path.empty())
+				{
+					return;
+				}
+			}
+		});
+
+		if (!watcher->valid())
+		{
+			std::cout << "Unable to watch for devices; reconnecting is disabled." << std::endl;
+			watcher.reset();
+		}
+	}
+
+	if (settings.feeder.latency)
+	{
+		// Print the latency so far whenever Enter is pressed.
+		std::thread([&devices]
+		{
+			std::string line;
+
+			while (std::getline(std::cin, line))
+			{
+				for (const auto& device : devices)
+				{
+					device->feeder->latency().print(std::cout);
+				}
+			}
+		}).detach();
+	}
+
+	if (several)
+	{
+		if (watcher)
+		{
+			loop.onEnded(disconnect);
+		}
+
+		loop.run();
+	}
+	else
+	{
+		devices[0]->feeder->run();
+
+		while (watcher)
+		{
+			disconnect(0);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			reconnected.wait(lock, [&devices] { return !devices[0]->path.empty(); });
+			lock.unlock();
+
+			devices[0]->feeder->run();
+		}
+	}
+
+	if (replay)
+	{
+		std::cout << "End of capture file." << std::endl;
+	}
+	else if (simulator)
+	{
+		std::cout << "Simulated reports: " << std::dec << simulator->generated() << ", late: " << simulator->late()
+		          << ", max lag: " << std::chrono::duration_cast<std::chrono::microseconds>(simulator->maxLag()).count() << " us" << std::endl;
+	}
+	else
+	{
+		std::cout << "Failed to read data from device." << std::endl;
+	}
+
+	for (const auto& device : devices)
+	{
+		if (several)
+		{
+			std::cout << "Device " << std::dec << device->config.id << ":" << std::endl;
+		}
+
+		if (settings.feeder.coalesce)
+		{
+			std::cout << "Coalesced reports: " << std::dec << device->feeder->coalesced() << std::endl;
+		}
+
+		if (settings.feeder.staleAfter != 0)
+		{
+			std::cout << "Flushed backlogs: " << std::dec << device->feeder->flushes() << std::endl;
+		}
+
+		if (settings.feeder.latency)
+		{
+			device->feeder->latency().print(std::cout);
+		}
+
+		if (device->hDev != INVALID_DEV)
+		{
+			RelinquishDev(device->hDev);
+		}
+	}
+
+	return 0;
+}
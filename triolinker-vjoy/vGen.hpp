@@ -0,0 +1,53 @@
+/**
+ * triolinker-vjoy
+ * Include guard for vGenInterface.h, which doesn't have one of its own.
+ */
+
+#ifndef VGEN_HPP
+#define VGEN_HPP
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Xinput.h>
+
+#include <vGenInterface.h>
+
+#ifndef VJOYHEADERUSED
+/**
+ * vJoy position block, as consumed by UpdateVJD.
+ * Mirrors JOYSTICK_POSITION_V2 from the vJoy SDK's public.h,
+ * which the vGen SDK doesn't ship.
+ */
+typedef struct _JOYSTICK_POSITION_V2
+{
+	BYTE  bDevice; // 1-based vJoy device ID
+	LONG  wThrottle;
+	LONG  wRudder;
+	LONG  wAileron;
+	LONG  wAxisX;
+	LONG  wAxisY;
+	LONG  wAxisZ;
+	LONG  wAxisXRot;
+	LONG  wAxisYRot;
+	LONG  wAxisZRot;
+	LONG  wSlider;
+	LONG  wDial;
+	LONG  wWheel;
+	LONG  wAxisVX;
+	LONG  wAxisVY;
+	LONG  wAxisVZ;
+	LONG  wAxisVBRX;
+	LONG  wAxisVBRY;
+	LONG  wAxisVBRZ;
+	LONG  lButtons; // buttons 1-32, one bit each
+	DWORD bHats;    // continuous POV 1 in 1/100 degrees, or -1 for neutral
+	DWORD bHatsEx1;
+	DWORD bHatsEx2;
+	DWORD bHatsEx3;
+	LONG  lButtonsEx1;
+	LONG  lButtonsEx2;
+	LONG  lButtonsEx3;
+} JOYSTICK_POSITION_V2, *PJOYSTICK_POSITION_V2;
+#endif
+
+#endif /* VGEN_HPP */
@@ -0,0 +1,39 @@
+/**
+ * triolinker-vjoy
+ * Win32 types needed by vGenInterface.h and VJoyOutput on other platforms.
+ * Only used when building against the vGen mock.
+ */
+
+#ifndef VGENMOCK_WINDOWS_H
+#define VGENMOCK_WINDOWS_H
+
+#include <cstdint>
+
+typedef int            BOOL;
+typedef int            INT;
+typedef unsigned int   UINT;
+typedef unsigned char  UCHAR;
+typedef unsigned char  BYTE;
+typedef int16_t        SHORT;
+typedef uint16_t       USHORT;
+typedef uint16_t       WORD;
+typedef int32_t        LONG;
+typedef uint32_t       ULONG;
+typedef uint32_t       DWORD;
+typedef float          FLOAT;
+typedef void           VOID;
+typedef void*          PVOID;
+typedef BOOL*          PBOOL;
+typedef BYTE*          PBYTE;
+typedef char           CHAR;
+
+#define TRUE  1
+#define FALSE 0
+
+#define CALLBACK
+#define __cdecl
+#define __declspec(x)
+
+#define WM_USER 0x0400
+
+#endif /* VGENMOCK_WINDOWS_H */
@@ -0,0 +1,23 @@
+/**
+ * triolinker-vjoy
+ * XInput types needed by vGenInterface.h on other platforms.
+ * Only used when building against the vGen mock.
+ */
+
+#ifndef VGENMOCK_XINPUT_H
+#define VGENMOCK_XINPUT_H
+
+#include "Windows.h"
+
+#define XINPUT_GAMEPAD_DPAD_UP    0x0001
+#define XINPUT_GAMEPAD_DPAD_DOWN  0x0002
+#define XINPUT_GAMEPAD_DPAD_LEFT  0x0004
+#define XINPUT_GAMEPAD_DPAD_RIGHT 0x0008
+
+typedef struct _XINPUT_VIBRATION
+{
+	WORD wLeftMotorSpeed;
+	WORD wRightMotorSpeed;
+} XINPUT_VIBRATION, *PXINPUT_VIBRATION;
+
+#endif /* VGENMOCK_XINPUT_H */
@@ -0,0 +1,589 @@
+/**
+ * triolinker-vjoy
+ * Stand-in for vGenInterface.dll that records calls instead of driving vJoy.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#ifndef VGENINTERFACE_EXPORTS
+#define VGENINTERFACE_EXPORTS
+#endif
+
+#include "vGen.hpp"
+#include "vGenMock.hpp"
+
+constexpr UINT VJOY_DEVICES = 16;
+constexpr UINT XBOX_DEVICES = 4;
+
+constexpr LONG AXIS_MIN = 0;
+constexpr LONG AXIS_MAX = 0x8000;
+
+/**
+ * A vJoy device or vXbox controller, keyed by its handle.
+ */
+struct MockDevice
+{
+	bool      acquired = false;
+	MockState state;
+};
+
+/*
+ * Trace storage is a preallocated ring, so recording never allocates.
+ * Everything below is guarded by the mutex, except the latency.
+ */
+static std::mutex                mutex;
+static std::vector<MockCall>     trace(static_cast<size_t>(1) << 20);
+static uint64_t                  callCount  = 0;
+static bool                      configured = false; // environment variables read
+static bool                      discrete   = false; // POV 1 is a 4-direction POV rather than a continuous one
+static std::map<int, MockDevice> devices;
+static std::string               tracePath;
+static std::atomic<uint64_t>     latency { 0 };
+
+static std::chrono::steady_clock::time_point start;
+
+/**
+ * Records a call and holds the lock while the call updates device state.
+ * The simulated latency is spent after the lock is released, so calls from
+ * several threads overlap the way calls into the driver would.
+ */
+class MockCallScope
+{
+public:
+	MockCallScope(MockFunction function, UINT device, UINT index, int64_t value)
+		: m_lock(mutex),
+		  m_start(std::chrono::steady_clock::now())
+	{
+		if (callCount == 0)
+		{
+			start = m_start;
+		}
+
+		if (!trace.empty())
+		{
+			trace[callCount % trace.size()] = {
+				static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_start - start).count()),
+				function, static_cast<uint16_t>(device), index, value
+			};
+		}
+
+		++callCount;
+	}
+
+	~MockCallScope()
+	{
+		m_lock.unlock();
+
+		// Busy-wait, since sleeping can't hit microsecond delays reliably.
+		const auto until = m_start + std::chrono::nanoseconds(latency.load(std::memory_order_relaxed));
+
+		while (std::chrono::steady_clock::now() < until)
+		{
+		}
+	}
+
+	MockCallScope(const MockCallScope&) = delete;
+	MockCallScope& operator=(const MockCallScope&) = delete;
+
+protected:
+	std::unique_lock<std::mutex>          m_lock;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @param handle Device handle. Called with the mutex held.
+ * @return State of an acquired device, or nullptr.
+ */
+static MockState* deviceState(int handle)
+{
+	const auto it = devices.find(handle);
+	return it != devices.end() && it->second.acquired ? &it->second.state : nullptr;
+}
+
+static MockState* vJoyState(UINT id)
+{
+	return id >= 1 && id <= VJOY_DEVICES ? deviceState(static_cast<int>(id)) : nullptr;
+}
+
+static MockState* xboxState(UINT index)
+{
+	return index >= 1 && index <= XBOX_DEVICES ? deviceState(MOCK_XBOX_HANDLE + static_cast<int>(index)) : nullptr;
+}
+
+static bool validAxis(UINT axis)
+{
+	return axis >= HID_USAGE_X && axis <= HID_USAGE_SL1;
+}
+
+static DWORD setThumb(MockState* state, size_t thumb, SHORT value)
+{
+	if (state == nullptr)
+	{
+		return 1;
+	}
+
+	state->thumbs[thumb] = value;
+	return 0;
+}
+
+static bool setButton(MockState* state, UINT button, BOOL value)
+{
+	if (state == nullptr || button < 1 || button > 32)
+	{
+		return false;
+	}
+
+	const uint32_t mask = 1u << (button - 1);
+	state->buttons = value ? state->buttons | mask : state->buttons & ~mask;
+	return true;
+}
+
+void mockSetLatency(uint64_t nanoseconds)
+{
+	latency.store(nanoseconds, std::memory_order_relaxed);
+}
+
+/**
+ * @param enabled True to give every device a discrete 4-direction POV, false for a continuous one.
+ */
+void mockSetDiscretePov(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	discrete = enabled;
+}
+
+void mockSetTraceSize(size_t calls)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	trace.assign(calls, MockCall {});
+	callCount = 0;
+}
+
+/**
+ * Forget the recorded calls and bring every device back to its initial state.
+ */
+void mockClearTrace()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	callCount = 0;
+
+	for (auto& [handle, device] : devices)
+	{
+		device.state = MockState {};
+	}
+}
+
+/**
+ * @return Number of calls made, including any that no longer fit in the trace.
+ */
+uint64_t mockCallCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return callCount;
+}
+
+/**
+ * @return Recorded calls, oldest first. Only the most recent calls are kept
+ * once more than the trace size were made.
+ */
+std::vector<MockCall> mockTrace()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<MockCall>       result;
+
+	if (trace.empty())
+	{
+		return result;
+	}
+
+	const uint64_t first = callCount > trace.size() ? callCount - trace.size() : 0;
+
+	for (uint64_t i = first; i < callCount; i++)
+	{
+		result.push_back(trace[i % trace.size()]);
+	}
+
+	return result;
+}
+
+/**
+ * @param handle Device handle, as returned by AcquireDev.
+ * @return State of the device, or the initial state if it was never acquired.
+ */
+MockState mockState(int handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto it = devices.find(handle);
+	return it != devices.end() ? it->second.state : MockState {};
+}
+
+/**
+ * Write the trace as text, one call per line: time, function, device, index, value.
+ * @param path Output file.
+ * @return True on success.
+ */
+bool mockWriteTrace(const std::string& path)
+{
+	std::ofstream stream(path);
+
+	for (const auto& call : mockTrace())
+	{
+		stream << call.time << ' ' << mockFunctionName(call.function) << ' ' << call.device << ' '
+		       << call.index << ' ' << call.value << '\n';
+	}
+
+	return stream.good();
+}
+
+const char* mockFunctionName(MockFunction function)
+{
+	switch (function)
+	{
+		case MockFunction::AcquireDev:    return "AcquireDev";
+		case MockFunction::RelinquishDev: return "RelinquishDev";
+		case MockFunction::SetAxis:       return "SetAxis";
+		case MockFunction::SetBtn:        return "SetBtn";
+		case MockFunction::SetContPov:    return "SetContPov";
+		case MockFunction::SetDiscPov:    return "SetDiscPov";
+		case MockFunction::UpdateVJD:     return "UpdateVJD";
+		case MockFunction::SetDevAxis:    return "SetDevAxis";
+		case MockFunction::SetDevButton:  return "SetDevButton";
+		case MockFunction::SetDevPov:     return "SetDevPov";
+		case MockFunction::SetButton:     return "SetButton";
+		case MockFunction::SetTriggerL:   return "SetTriggerL";
+		case MockFunction::SetTriggerR:   return "SetTriggerR";
+		case MockFunction::SetAxisLx:     return "SetAxisLx";
+		case MockFunction::SetAxisLy:     return "SetAxisLy";
+		case MockFunction::SetAxisRx:     return "SetAxisRx";
+		case MockFunction::SetAxisRy:     return "SetAxisRy";
+		case MockFunction::SetDpad:       return "SetDpad";
+	}
+
+	return "?";
+}
+
+extern "C"
+{
+	DWORD __cdecl AcquireDev(UINT DevId, DevType dType, HDEVICE* hDev)
+	{
+		// Read before the call is recorded, since the trace size resets the trace.
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (!configured)
+			{
+				configured = true;
+
+				if (const char* value = std::getenv("VGEN_MOCK_TRACE_SIZE"))
+				{
+					trace.assign(std::strtoull(value, nullptr, 10), MockCall {});
+					callCount = 0;
+				}
+
+				if (const char* value = std::getenv("VGEN_MOCK_LATENCY_NS"))
+				{
+					latency.store(std::strtoull(value, nullptr, 10), std::memory_order_relaxed);
+				}
+
+				if (const char* value = std::getenv("VGEN_MOCK_TRACE"))
+				{
+					tracePath = value;
+				}
+			}
+		}
+
+		const MockCallScope call(MockFunction::AcquireDev, DevId, 0, dType);
+
+		const UINT count  = dType == DevType::vXbox ? XBOX_DEVICES : VJOY_DEVICES;
+		const int  handle = (dType == DevType::vXbox ? MOCK_XBOX_HANDLE : 0) + static_cast<int>(DevId);
+
+		if (DevId < 1 || DevId > count || hDev == nullptr || devices[handle].acquired)
+		{
+			return 1;
+		}
+
+		devices[handle] = { true, MockState {} };
+		*hDev = handle;
+		return 0;
+	}
+
+	DWORD __cdecl RelinquishDev(HDEVICE hDev)
+	{
+		std::string path;
+
+		{
+			const MockCallScope call(MockFunction::RelinquishDev, static_cast<UINT>(hDev), 0, 0);
+
+			if (deviceState(hDev) == nullptr)
+			{
+				return 1;
+			}
+
+			devices[hDev].acquired = false;
+
+			// The trace is written once every device is released.
+			if (std::none_of(devices.begin(), devices.end(), [](const auto& device) { return device.second.acquired; }))
+			{
+				path = tracePath;
+			}
+		}
+
+		if (!path.empty())
+		{
+			mockWriteTrace(path);
+		}
+
+		return 0;
+	}
+
+	DWORD __cdecl GetDevId(HDEVICE hDev, UINT* dID)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (deviceState(hDev) == nullptr)
+		{
+			return 1;
+		}
+
+		*dID = static_cast<UINT>(hDev > MOCK_XBOX_HANDLE ? hDev - MOCK_XBOX_HANDLE : hDev);
+		return 0;
+	}
+
+	int __cdecl GetVJDContPovNumber(UINT rID)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return vJoyState(rID) != nullptr && !discrete ? 1 : 0;
+	}
+
+	int __cdecl GetVJDDiscPovNumber(UINT rID)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return vJoyState(rID) != nullptr && discrete ? 1 : 0;
+	}
+
+	BOOL __cdecl GetVJDAxisMin(UINT rID, UINT Axis, LONG* Min)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (vJoyState(rID) == nullptr || !validAxis(Axis))
+		{
+			return FALSE;
+		}
+
+		*Min = AXIS_MIN;
+		return TRUE;
+	}
+
+	BOOL __cdecl GetVJDAxisMax(UINT rID, UINT Axis, LONG* Max)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (vJoyState(rID) == nullptr || !validAxis(Axis))
+		{
+			return FALSE;
+		}
+
+		*Max = AXIS_MAX;
+		return TRUE;
+	}
+
+	BOOL __cdecl SetAxis(LONG Value, UINT rID, UINT Axis)
+	{
+		const MockCallScope call(MockFunction::SetAxis, rID, Axis, Value);
+		MockState* const    state = vJoyState(rID);
+
+		if (state == nullptr || !validAxis(Axis))
+		{
+			return FALSE;
+		}
+
+		state->axes[Axis - HID_USAGE_X] = Value;
+		return TRUE;
+	}
+
+	BOOL __cdecl SetBtn(BOOL Value, UINT rID, UCHAR nBtn)
+	{
+		const MockCallScope call(MockFunction::SetBtn, rID, nBtn, Value);
+		return setButton(vJoyState(rID), nBtn, Value) ? TRUE : FALSE;
+	}
+
+	BOOL __cdecl SetContPov(DWORD Value, UINT rID, UCHAR nPov)
+	{
+		const MockCallScope call(MockFunction::SetContPov, rID, nPov, static_cast<int32_t>(Value));
+		MockState* const    state = vJoyState(rID);
+
+		if (state == nullptr || nPov != 1)
+		{
+			return FALSE;
+		}
+
+		state->pov = Value;
+		return TRUE;
+	}
+
+	BOOL __cdecl SetDiscPov(int Value, UINT rID, UCHAR nPov)
+	{
+		const MockCallScope call(MockFunction::SetDiscPov, rID, nPov, Value);
+		MockState* const    state = vJoyState(rID);
+
+		if (state == nullptr || nPov != 1 || Value < -1 || Value > 3)
+		{
+			return FALSE;
+		}
+
+		state->pov = static_cast<uint32_t>(Value);
+		return TRUE;
+	}
+
+	BOOL __cdecl UpdateVJD(UINT rID, PVOID pData)
+	{
+		const auto*         position = static_cast<const JOYSTICK_POSITION_V2*>(pData);
+		const MockCallScope call(MockFunction::UpdateVJD, rID, position->bHats, position->lButtons);
+		MockState* const    state = vJoyState(rID);
+
+		if (state == nullptr)
+		{
+			return FALSE;
+		}
+
+		state->axes[0] = position->wAxisX;
+		state->axes[1] = position->wAxisY;
+		state->axes[2] = position->wAxisZ;
+		state->axes[3] = position->wAxisXRot;
+		state->axes[4] = position->wAxisYRot;
+		state->axes[5] = position->wAxisZRot;
+		state->axes[6] = position->wSlider;
+		state->axes[7] = position->wDial;
+		state->buttons = static_cast<uint32_t>(position->lButtons);
+		state->pov     = position->bHats;
+
+		// A discrete POV is the low nibble, 0xF when centered.
+		if (discrete)
+		{
+			state->pov = (position->bHats & 0xF) == 0xF ? 0xFFFFFFFF : position->bHats & 0xF;
+		}
+
+		return TRUE;
+	}
+
+	DWORD __cdecl SetDevAxis(HDEVICE hDev, UINT Axis, FLOAT Value)
+	{
+		const MockCallScope call(MockFunction::SetDevAxis, static_cast<UINT>(hDev), Axis, static_cast<int64_t>(Value * 1000.0f));
+		MockState* const    state = deviceState(hDev);
+
+		// vGen takes percentages and numbers axes from 1.
+		if (state == nullptr || Axis < 1 || Axis > 8)
+		{
+			return 1;
+		}
+
+		state->axes[Axis - 1] = AXIS_MIN + static_cast<LONG>(Value / 100.0f * (AXIS_MAX - AXIS_MIN));
+		return 0;
+	}
+
+	DWORD __cdecl SetDevButton(HDEVICE hDev, UINT Button, BOOL Press)
+	{
+		const MockCallScope call(MockFunction::SetDevButton, static_cast<UINT>(hDev), Button, Press);
+		return setButton(deviceState(hDev), Button, Press) ? 0 : 1;
+	}
+
+	DWORD __cdecl SetDevPov(HDEVICE hDev, UINT nPov, FLOAT Value)
+	{
+		const MockCallScope call(MockFunction::SetDevPov, static_cast<UINT>(hDev), nPov, static_cast<int64_t>(Value * 1000.0f));
+		MockState* const    state = deviceState(hDev);
+
+		if (state == nullptr || nPov != 1)
+		{
+			return 1;
+		}
+
+		state->pov = Value < 0.0f ? 0xFFFFFFFF : static_cast<DWORD>(Value * 100.0f);
+		return 0;
+	}
+
+	DWORD __cdecl SetButton(UINT UserIndex, WORD Button, BOOL Press)
+	{
+		const MockCallScope call(MockFunction::SetButton, UserIndex, Button, Press);
+		MockState* const    state = xboxState(UserIndex);
+
+		if (state == nullptr)
+		{
+			return 1;
+		}
+
+		state->xboxButtons = Press ? state->xboxButtons | Button : state->xboxButtons & ~Button;
+		return 0;
+	}
+
+	DWORD __cdecl SetTriggerL(UINT UserIndex, BYTE Value)
+	{
+		const MockCallScope call(MockFunction::SetTriggerL, UserIndex, 0, Value);
+		MockState* const    state = xboxState(UserIndex);
+
+		if (state == nullptr)
+		{
+			return 1;
+		}
+
+		state->triggers[0] = Value;
+		return 0;
+	}
+
+	DWORD __cdecl SetTriggerR(UINT UserIndex, BYTE Value)
+	{
+		const MockCallScope call(MockFunction::SetTriggerR, UserIndex, 0, Value);
+		MockState* const    state = xboxState(UserIndex);
+
+		if (state == nullptr)
+		{
+			return 1;
+		}
+
+		state->triggers[1] = Value;
+		return 0;
+	}
+
+	DWORD __cdecl SetAxisLx(UINT UserIndex, SHORT Value)
+	{
+		const MockCallScope call(MockFunction::SetAxisLx, UserIndex, 0, Value);
+		return setThumb(xboxState(UserIndex), 0, Value);
+	}
+
+	DWORD __cdecl SetAxisLy(UINT UserIndex, SHORT Value)
+	{
+		const MockCallScope call(MockFunction::SetAxisLy, UserIndex, 0, Value);
+		return setThumb(xboxState(UserIndex), 1, Value);
+	}
+
+	DWORD __cdecl SetAxisRx(UINT UserIndex, SHORT Value)
+	{
+		const MockCallScope call(MockFunction::SetAxisRx, UserIndex, 0, Value);
+		return setThumb(xboxState(UserIndex), 2, Value);
+	}
+
+	DWORD __cdecl SetAxisRy(UINT UserIndex, SHORT Value)
+	{
+		const MockCallScope call(MockFunction::SetAxisRy, UserIndex, 0, Value);
+		return setThumb(xboxState(UserIndex), 3, Value);
+	}
+
+	DWORD __cdecl SetDpad(UINT UserIndex, UCHAR Value)
+	{
+		const MockCallScope call(MockFunction::SetDpad, UserIndex, 0, Value);
+		MockState* const    state = xboxState(UserIndex);
+
+		if (state == nullptr)
+		{
+			return 1;
+		}
+
+		state->xboxButtons = static_cast<uint16_t>((state->xboxButtons & ~0x000F) | (Value & 0x000F));
+		return 0;
+	}
+}
@@ -0,0 +1,88 @@
+/**
+ * triolinker-vjoy
+ * Stand-in for vGenInterface.dll that records calls instead of driving vJoy.
+ */
+
+#ifndef VGENMOCK_HPP
+#define VGENMOCK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class MockFunction : uint16_t
+{
+	AcquireDev,
+	RelinquishDev,
+	SetAxis,
+	SetBtn,
+	SetContPov,
+	SetDiscPov,
+	UpdateVJD,
+	SetDevAxis,
+	SetDevButton,
+	SetDevPov,
+	SetButton,
+	SetTriggerL,
+	SetTriggerR,
+	SetAxisLx,
+	SetAxisLy,
+	SetAxisRx,
+	SetAxisRy,
+	SetDpad,
+};
+
+/**
+ * A single recorded call.
+ */
+struct MockCall
+{
+	uint64_t     time;     // nanoseconds since the first call
+	MockFunction function;
+	uint16_t     device;   // vJoy device ID, vXbox user index or handle
+	uint32_t     index;    // axis usage, button or POV number; POV for UpdateVJD, XInput button bit for SetButton
+	int64_t      value;    // value written; buttons for UpdateVJD, device type for AcquireDev (float values scaled by 1000)
+};
+
+/**
+ * Current state of a mocked vJoy device or vXbox controller, as set by the recorded calls.
+ */
+struct MockState
+{
+	int32_t  axes[8] {}; // HID_USAGE_X to HID_USAGE_SL1
+	uint32_t buttons = 0;
+	uint32_t pov     = 0xFFFFFFFF; // continuous POV in 1/100 degrees, or discrete POV direction (0-3); 0xFFFFFFFF when centered
+
+	// vXbox, laid out like XINPUT_GAMEPAD.
+	uint16_t xboxButtons = 0;
+	uint8_t  triggers[2] {};
+	int16_t  thumbs[4] {}; // LX, LY, RX, RY
+};
+
+// Handle AcquireDev gives vXbox controller n; vJoy device n has handle n.
+constexpr int MOCK_XBOX_HANDLE = 0x100;
+
+/*
+ * The mock serves vJoy devices 1 to 16 and vXbox controllers 1 to 4, each
+ * with its own state, and may be called from several threads at once.
+ * It is configured through these functions or, so an unmodified feeder
+ * can use it, through environment variables read by the first AcquireDev:
+ * VGEN_MOCK_LATENCY_NS  Busy-wait this long inside every output call.
+ * VGEN_MOCK_TRACE       Write the trace to this file when the last device is released.
+ * VGEN_MOCK_TRACE_SIZE  Number of calls kept in memory (default 1048576).
+ */
+
+void mockSetLatency(uint64_t nanoseconds);
+void mockSetDiscretePov(bool discrete);
+void mockSetTraceSize(size_t calls);
+void mockClearTrace();
+
+uint64_t mockCallCount();
+std::vector<MockCall> mockTrace();
+MockState mockState(int handle = 1);
+bool mockWriteTrace(const std::string& path);
+
+const char* mockFunctionName(MockFunction function);
+
+#endif /* VGENMOCK_HPP */